@@ -0,0 +1,82 @@
+#ifndef RMW_ZENOHPICO_C__CLIENT_H_
+#define RMW_ZENOHPICO_C__CLIENT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rmw/ret_types.h"
+#include "rmw/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  // Number of requests sent that were not answered, did not time out and did not fail yet.
+  size_t in_flight_request_count;
+  // Number of calls to rmw_send_request() that failed because in_flight_request_count had reached
+  // RMW_ZENOHPICO_CLIENT_MAX_IN_FLIGHT.
+  size_t rejected_request_count;
+  // Number of requests that got no reply within the query timeout.
+  size_t timed_out_request_count;
+  // Number of requests answered with an error reply before any valid one, e.g. because the service
+  // rejected them.
+  size_t error_reply_count;
+  // Number of requests that ended without a reply before the timeout, e.g. because no service
+  // server was available.
+  size_t unanswered_request_count;
+  // Number of replies received for requests of this client, i.e. the first reply to each request.
+  size_t response_count;
+  // Number of replies dropped because they did not answer a request of this client that was still
+  // in flight, or because the request was already answered.
+  size_t unexpected_reply_count;
+  // Round-trip time of the last request answered, and the minimum, maximum and sum over all
+  // response_count requests answered, in microseconds.
+  uint64_t round_trip_time_last_us;
+  uint64_t round_trip_time_min_us;
+  uint64_t round_trip_time_max_us;
+  uint64_t round_trip_time_total_us;
+} rmw_zenohpico_client_statistics_t;
+
+// Queryables a request is sent to.
+typedef enum {
+  // The queryable that best matches the service, e.g. the closest one.
+  RMW_ZENOHPICO_QUERY_TARGET_BEST_MATCHING,
+  RMW_ZENOHPICO_QUERY_TARGET_ALL,
+  RMW_ZENOHPICO_QUERY_TARGET_ALL_COMPLETE,
+} rmw_zenohpico_query_target_t;
+
+// Consolidation of the replies to a request, see RMW_ZENOHPICO_CLIENT_QUERY_CONSOLIDATION.
+typedef enum {
+  RMW_ZENOHPICO_QUERY_CONSOLIDATION_AUTO,
+  // Replies are forwarded as soon as they arrive.
+  RMW_ZENOHPICO_QUERY_CONSOLIDATION_NONE,
+  RMW_ZENOHPICO_QUERY_CONSOLIDATION_MONOTONIC,
+  // Replies are held back until the query is complete.
+  RMW_ZENOHPICO_QUERY_CONSOLIDATION_LATEST,
+} rmw_zenohpico_query_consolidation_t;
+
+/// Set the time after which the requests sent from now on are given up on if they get no reply,
+/// overriding the default from RMW_ZENOHPICO_CLIENT_QUERY_TIMEOUT_MS. 0 means no timeout.
+rmw_ret_t rmw_zenohpico_client_set_query_timeout(rmw_client_t* client, size_t timeout_ms);
+
+/// Set the queryables the requests sent from now on are sent to, overriding the default from
+/// RMW_ZENOHPICO_CLIENT_QUERY_TARGET.
+rmw_ret_t rmw_zenohpico_client_set_query_target(rmw_client_t* client,
+                                                rmw_zenohpico_query_target_t target);
+
+/// Set the consolidation of the replies to the requests sent from now on, overriding the default
+/// from RMW_ZENOHPICO_CLIENT_QUERY_CONSOLIDATION. Only the first reply to each request is taken,
+/// whatever the consolidation.
+rmw_ret_t rmw_zenohpico_client_set_query_consolidation(
+    rmw_client_t* client, rmw_zenohpico_query_consolidation_t consolidation);
+
+/// Retrieve implementation specific statistics of a client created by rmw_zenohpico_c.
+rmw_ret_t rmw_zenohpico_client_get_statistics(const rmw_client_t* client,
+                                              rmw_zenohpico_client_statistics_t* statistics);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
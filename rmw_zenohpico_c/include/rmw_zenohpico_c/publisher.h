@@ -0,0 +1,29 @@
+#ifndef RMW_ZENOHPICO_C__PUBLISHER_H_
+#define RMW_ZENOHPICO_C__PUBLISHER_H_
+
+#include <stddef.h>
+
+#include "rmw/ret_types.h"
+#include "rmw/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  // Current capacity (in bytes) of the buffer the publisher reuses to serialize messages.
+  size_t serialization_buffer_capacity;
+  // Number of publications whose serialized size exceeded the configured maximum buffer size
+  // (RMW_ZENOHPICO_SERIALIZATION_BUFFER_MAX_SIZE) and needed a one-off allocation.
+  size_t serialization_buffer_fallback_count;
+} rmw_zenohpico_publisher_statistics_t;
+
+/// Retrieve implementation specific statistics of a publisher created by rmw_zenohpico_c.
+rmw_ret_t rmw_zenohpico_publisher_get_statistics(
+    const rmw_publisher_t* publisher, rmw_zenohpico_publisher_statistics_t* statistics);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
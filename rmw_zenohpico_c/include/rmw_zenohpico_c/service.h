@@ -0,0 +1,32 @@
+#ifndef RMW_ZENOHPICO_C__SERVICE_H_
+#define RMW_ZENOHPICO_C__SERVICE_H_
+
+#include <stddef.h>
+
+#include "rmw/ret_types.h"
+#include "rmw/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  // Number of requests received but not responded to yet, whether they were taken or not.
+  size_t pending_request_count;
+  // Number of requests answered with an error reply on arrival, because pending_request_count had
+  // reached RMW_ZENOHPICO_SERVICE_MAX_PENDING_QUERIES.
+  size_t rejected_request_count;
+  // Number of requests answered with an error reply because they were dropped from the request
+  // queue, which already held `depth` requests that had not been taken.
+  size_t request_queue_overflow_count;
+} rmw_zenohpico_service_statistics_t;
+
+/// Retrieve implementation specific statistics of a service created by rmw_zenohpico_c.
+rmw_ret_t rmw_zenohpico_service_get_statistics(const rmw_service_t* service,
+                                               rmw_zenohpico_service_statistics_t* statistics);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef RMW_ZENOHPICO_C__SUBSCRIPTION_H_
+#define RMW_ZENOHPICO_C__SUBSCRIPTION_H_
+
+#include <stddef.h>
+
+#include "rmw/ret_types.h"
+#include "rmw/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  // Number of received messages discarded because the queue already held `depth` messages that
+  // had not been taken.
+  size_t queue_overflow_count;
+  // Number of messages that never arrived, detected from gaps in the sequence numbers of each
+  // publisher.
+  size_t sequence_gap_count;
+  // Number of received messages dropped without being taken because they outlived the lifespan
+  // QoS of the subscription.
+  size_t lifespan_expired_count;
+} rmw_zenohpico_subscription_statistics_t;
+
+/// Retrieve implementation specific statistics of a subscription created by rmw_zenohpico_c.
+/**
+ * queue_overflow_count and sequence_gap_count are also reported through
+ * RMW_EVENT_MESSAGE_LOST.
+ *
+ * Sequence numbers are tracked for the 16 publishers heard from most recently. With more
+ * publishers sending to the subscription, gaps of the ones that were forgotten in between are
+ * not reported.
+ */
+rmw_ret_t rmw_zenohpico_subscription_get_statistics(
+    const rmw_subscription_t* subscription, rmw_zenohpico_subscription_statistics_t* statistics);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
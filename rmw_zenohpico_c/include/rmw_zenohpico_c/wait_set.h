@@ -0,0 +1,46 @@
+#ifndef RMW_ZENOHPICO_C__WAIT_SET_H_
+#define RMW_ZENOHPICO_C__WAIT_SET_H_
+
+#include <stddef.h>
+
+#include "rmw/ret_types.h"
+#include "rmw/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  // Number of calls to rmw_wait() where an entity became ready while polling, before the spin
+  // period expired.
+  size_t spin_wakeup_count;
+  // Number of calls to rmw_wait() where an entity became ready while blocked on the condition
+  // variable.
+  size_t block_wakeup_count;
+} rmw_zenohpico_wait_set_statistics_t;
+
+/// Set the time rmw_wait() polls for ready entities before blocking, overriding the default from
+/// RMW_ZENOHPICO_WAIT_SPIN_PERIOD_US. 0 disables spinning.
+rmw_ret_t rmw_zenohpico_wait_set_set_spin_period(rmw_wait_set_t* wait_set, size_t spin_period_us);
+
+/// Retrieve implementation specific statistics of a wait set created by rmw_zenohpico_c.
+rmw_ret_t rmw_zenohpico_wait_set_get_statistics(const rmw_wait_set_t* wait_set,
+                                                rmw_zenohpico_wait_set_statistics_t* statistics);
+
+/// Get a file descriptor that is readable while an entity attached to the wait set is ready, so
+/// that the wait set can be polled (e.g. with epoll) together with other file descriptors.
+/**
+ * Entities are attached to the wait set by rmw_wait(), and stay attached as long as rmw_wait() is
+ * given the same ones. Once the descriptor is readable, call rmw_wait() with a zero timeout to find
+ * out which entities are ready. The descriptor is owned by the wait set and closed when it is
+ * destroyed; do not read from it.
+ *
+ * Only supported on Linux, returns RMW_RET_UNSUPPORTED on other platforms.
+ */
+rmw_ret_t rmw_zenohpico_wait_set_get_fd(rmw_wait_set_t* wait_set, int* fd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
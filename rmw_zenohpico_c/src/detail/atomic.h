@@ -0,0 +1,13 @@
+#ifndef RMW_ZENOHPICO_DETAIL__ATOMIC_H_
+#define RMW_ZENOHPICO_DETAIL__ATOMIC_H_
+
+// Counters that are updated on every publication, request or reply use C11 atomics. On toolchains
+// without <stdatomic.h> (RMW_ZP_HAVE_ATOMICS is 0) they are guarded by a mutex instead.
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_ATOMICS__)
+#include <stdatomic.h>
+#define RMW_ZP_HAVE_ATOMICS 1
+#else
+#define RMW_ZP_HAVE_ATOMICS 0
+#endif
+
+#endif
\ No newline at end of file
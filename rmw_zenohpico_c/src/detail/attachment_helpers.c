@@ -1,11 +1,70 @@
 #include "./attachment_helpers.h"
 
+#include <string.h>
+
 #include "./macros.h"
 #include "rcutils/macros.h"
 #include "rmw/error_handling.h"
 
-rmw_ret_t rmw_zp_attachment_data_serialize_to_zbytes(
-    const rmw_zp_attachment_data_t *attachment_data, z_owned_bytes_t *attachment) {
+static void store_int64_le(uint8_t *dst, int64_t value) {
+  uint64_t bits = (uint64_t)value;
+  for (size_t i = 0; i < sizeof(bits); i++) {
+    dst[i] = (uint8_t)(bits >> (8 * i));
+  }
+}
+
+static int64_t load_int64_le(const uint8_t *src) {
+  uint64_t bits = 0;
+  for (size_t i = 0; i < sizeof(bits); i++) {
+    bits |= (uint64_t)src[i] << (8 * i);
+  }
+  return (int64_t)bits;
+}
+
+static rmw_ret_t serialize_compact(const rmw_zp_attachment_data_t *attachment_data,
+                                   z_owned_bytes_t *attachment) {
+  uint8_t record[RMW_ZP_ATTACHMENT_COMPACT_SIZE] = {RMW_ZP_ATTACHMENT_COMPACT_VERSION};
+  store_int64_le(&record[8], attachment_data->sequence_number);
+  store_int64_le(&record[16], attachment_data->source_timestamp);
+  memcpy(&record[24], attachment_data->source_gid, RMW_GID_STORAGE_SIZE);
+
+  if (z_bytes_copy_from_buf(attachment, record, sizeof(record)) < 0) {
+    RMW_SET_ERROR_MSG("Failed to create attachment bytes");
+    return RMW_RET_ERROR;
+  }
+
+  return RMW_RET_OK;
+}
+
+static rmw_ret_t deserialize_compact(const z_loaned_bytes_t *attachment,
+                                     rmw_zp_attachment_data_t *attachment_data) {
+  uint8_t record[RMW_ZP_ATTACHMENT_COMPACT_SIZE];
+  z_bytes_reader_t reader = z_bytes_get_reader(attachment);
+  if (z_bytes_reader_read(&reader, record, sizeof(record)) != sizeof(record)) {
+    RMW_SET_ERROR_MSG("Failed to read compact attachment");
+    return RMW_RET_ERROR;
+  }
+
+  attachment_data->sequence_number = load_int64_le(&record[8]);
+  attachment_data->source_timestamp = load_int64_le(&record[16]);
+  memcpy(attachment_data->source_gid, &record[24], RMW_GID_STORAGE_SIZE);
+
+  return RMW_RET_OK;
+}
+
+static bool is_compact(const z_loaned_bytes_t *attachment) {
+  if (z_bytes_len(attachment) != RMW_ZP_ATTACHMENT_COMPACT_SIZE) {
+    return false;
+  }
+
+  uint8_t version;
+  z_bytes_reader_t reader = z_bytes_get_reader(attachment);
+  return z_bytes_reader_read(&reader, &version, 1) == 1 &&
+         version == RMW_ZP_ATTACHMENT_COMPACT_VERSION;
+}
+
+static rmw_ret_t serialize_key_value(const rmw_zp_attachment_data_t *attachment_data,
+                                     z_owned_bytes_t *attachment) {
   ze_owned_serializer_t serializer;
   ze_serializer_empty(&serializer);
 
@@ -50,13 +109,8 @@ fail:
   return RMW_RET_ERROR;
 }
 
-rmw_ret_t rmw_zp_attachment_data_deserialize_from_zbytes(
-    const z_loaned_bytes_t *attachment, rmw_zp_attachment_data_t *attachment_data) {
-  if (z_bytes_is_empty(attachment)) {
-    RMW_SET_ERROR_MSG("Received empty attachment");
-    return RMW_RET_ERROR;
-  }
-
+static rmw_ret_t deserialize_key_value(const z_loaned_bytes_t *attachment,
+                                       rmw_zp_attachment_data_t *attachment_data) {
   ze_deserializer_t deserializer = ze_deserializer_from_bytes(attachment);
   z_owned_string_t key;
 
@@ -123,6 +177,79 @@ rmw_ret_t rmw_zp_attachment_data_deserialize_from_zbytes(
   return RMW_RET_OK;
 }
 
+rmw_ret_t rmw_zp_attachment_data_serialize_to_zbytes(
+    const rmw_zp_attachment_data_t *attachment_data, rmw_zp_attachment_format_t format,
+    z_owned_bytes_t *attachment) {
+  if (format == RMW_ZP_ATTACHMENT_FORMAT_COMPACT) {
+    return serialize_compact(attachment_data, attachment);
+  }
+  return serialize_key_value(attachment_data, attachment);
+}
+
+rmw_ret_t rmw_zp_attachment_data_deserialize_from_zbytes(
+    const z_loaned_bytes_t *attachment, rmw_zp_attachment_data_t *attachment_data) {
+  if (z_bytes_is_empty(attachment)) {
+    RMW_SET_ERROR_MSG("Received empty attachment");
+    return RMW_RET_ERROR;
+  }
+
+  if (is_compact(attachment)) {
+    return deserialize_compact(attachment, attachment_data);
+  }
+  return deserialize_key_value(attachment, attachment_data);
+}
+
+rmw_ret_t rmw_zp_attachment_template_init(rmw_zp_attachment_template_t *attachment_template,
+                                          const uint8_t *source_gid,
+                                          rmw_zp_attachment_format_t format) {
+  rmw_zp_attachment_data_t attachment_data = {.sequence_number = 0, .source_timestamp = 0};
+  memcpy(attachment_data.source_gid, source_gid, RMW_GID_STORAGE_SIZE);
+
+  size_t expected_size;
+  if (format == RMW_ZP_ATTACHMENT_FORMAT_COMPACT) {
+    expected_size = RMW_ZP_ATTACHMENT_COMPACT_SIZE;
+    attachment_template->sequence_number_offset = 8;
+    attachment_template->source_timestamp_offset = 16;
+  } else {
+    // Each int64 value follows its key, which is prefixed by a one byte length.
+    expected_size = RMW_ZP_ATTACHMENT_KEY_VALUE_SIZE;
+    attachment_template->sequence_number_offset = 1 + strlen("sequence_number");
+    attachment_template->source_timestamp_offset =
+        attachment_template->sequence_number_offset + sizeof(int64_t) + 1 +
+        strlen("source_timestamp");
+  }
+
+  z_owned_bytes_t attachment;
+  if (rmw_zp_attachment_data_serialize_to_zbytes(&attachment_data, format, &attachment) !=
+      RMW_RET_OK) {
+    return RMW_RET_ERROR;
+  }
+
+  rmw_ret_t ret = RMW_RET_OK;
+  if (z_bytes_len(z_loan(attachment)) != expected_size) {
+    RMW_SET_ERROR_MSG("Unexpected size of the encoded attachment");
+    ret = RMW_RET_ERROR;
+  } else {
+    z_bytes_reader_t reader = z_bytes_get_reader(z_loan(attachment));
+    if (z_bytes_reader_read(&reader, attachment_template->data, expected_size) != expected_size) {
+      RMW_SET_ERROR_MSG("Failed to read the encoded attachment");
+      ret = RMW_RET_ERROR;
+    }
+  }
+  z_drop(z_move(attachment));
+
+  attachment_template->size = expected_size;
+  return ret;
+}
+
+void rmw_zp_attachment_template_fill(const rmw_zp_attachment_template_t *attachment_template,
+                                     int64_t sequence_number, int64_t source_timestamp,
+                                     uint8_t *buffer) {
+  memcpy(buffer, attachment_template->data, attachment_template->size);
+  store_int64_le(&buffer[attachment_template->sequence_number_offset], sequence_number);
+  store_int64_le(&buffer[attachment_template->source_timestamp_offset], source_timestamp);
+}
+
 void rmw_zp_attachment_data_clone(const rmw_zp_attachment_data_t *attachment_data_src,
                                   rmw_zp_attachment_data_t *attachment_data_dst) {
   attachment_data_dst->sequence_number = attachment_data_src->sequence_number;
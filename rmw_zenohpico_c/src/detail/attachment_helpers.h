@@ -12,8 +12,55 @@ typedef struct {
   uint8_t source_gid[RMW_GID_STORAGE_SIZE];
 } rmw_zp_attachment_data_t;
 
+typedef enum {
+  // Serialized key/value pairs, the format used by rmw_zenoh_cpp.
+  RMW_ZP_ATTACHMENT_FORMAT_KEY_VALUE,
+  // Fixed-layout little-endian record:
+  //   [0]      RMW_ZP_ATTACHMENT_COMPACT_VERSION
+  //   [1, 8)   reserved, zero
+  //   [8, 16)  sequence_number
+  //   [16, 24) source_timestamp
+  //   [24, 24 + RMW_GID_STORAGE_SIZE) source_gid
+  RMW_ZP_ATTACHMENT_FORMAT_COMPACT,
+} rmw_zp_attachment_format_t;
+
+// A key/value attachment always starts with the length of the "sequence_number" key (0x0F), so
+// any other tag byte on a record of the compact size identifies the compact format.
+#define RMW_ZP_ATTACHMENT_COMPACT_VERSION 0xA1
+#define RMW_ZP_ATTACHMENT_COMPACT_SIZE    (24 + RMW_GID_STORAGE_SIZE)
+
+// Encoded size of a key/value attachment: the three keys with their one byte length prefixes, two
+// int64 values and the length-prefixed GID.
+#define RMW_ZP_ATTACHMENT_KEY_VALUE_SIZE (61 + RMW_GID_STORAGE_SIZE)
+
+// The key/value format is always the larger of the two.
+#define RMW_ZP_ATTACHMENT_TEMPLATE_MAX_SIZE RMW_ZP_ATTACHMENT_KEY_VALUE_SIZE
+
+// Attachment encoded once for a given source GID and format. Only the sequence number and the
+// source timestamp change between sends, and both are fixed-width little-endian fields in either
+// format, so they are patched in place into a copy of the template.
+typedef struct {
+  uint8_t data[RMW_ZP_ATTACHMENT_TEMPLATE_MAX_SIZE];
+  size_t size;
+  size_t sequence_number_offset;
+  size_t source_timestamp_offset;
+} rmw_zp_attachment_template_t;
+
+rmw_ret_t rmw_zp_attachment_template_init(rmw_zp_attachment_template_t* attachment_template,
+                                          const uint8_t* source_gid,
+                                          rmw_zp_attachment_format_t format);
+
+// Writes the attachment for one send into `buffer`, which must hold at least
+// `attachment_template->size` bytes.
+void rmw_zp_attachment_template_fill(const rmw_zp_attachment_template_t* attachment_template,
+                                     int64_t sequence_number, int64_t source_timestamp,
+                                     uint8_t* buffer);
+
 rmw_ret_t rmw_zp_attachment_data_serialize_to_zbytes(
-    const rmw_zp_attachment_data_t* attachment_data, z_owned_bytes_t* attachment);
+    const rmw_zp_attachment_data_t* attachment_data, rmw_zp_attachment_format_t format,
+    z_owned_bytes_t* attachment);
+
+// Accepts attachments in either format.
 
 rmw_ret_t rmw_zp_attachment_data_deserialize_from_zbytes(const z_loaned_bytes_t* attachment,
                                                          rmw_zp_attachment_data_t* attachment_data);
@@ -1,23 +1,56 @@
 #include "./client.h"
 
+#include <string.h>
+
 #include "./qos.h"
 #include "rmw/error_handling.h"
 
+static uint32_t to_query_timeout(size_t timeout_ms) {
+  // zenoh-pico has no way to disable the timeout, so use the longest one instead.
+  return timeout_ms == 0 || timeout_ms > UINT32_MAX ? UINT32_MAX : (uint32_t)timeout_ms;
+}
+
 rmw_ret_t rmw_zp_client_init(rmw_zp_client_t* client, const rmw_qos_profile_t* qos_profile,
+                             size_t query_timeout_ms, size_t max_in_flight,
+                             z_query_target_t query_target,
+                             z_consolidation_mode_t query_consolidation,
                              rcutils_allocator_t* allocator) {
-  client->sequence_number = 1;
   client->adapted_qos_profile = *qos_profile;
+  rmw_zp_waitable_init(&client->waitable);
   client->is_shutdown = false;
-  client->num_in_flight = 0;
+  client->max_in_flight = max_in_flight;
+  client->query_timeout_ms = to_query_timeout(query_timeout_ms);
+  client->query_target = query_target;
+  client->query_consolidation = query_consolidation;
+  client->rejected_request_count = 0;
+  client->timed_out_request_count = 0;
+  client->error_reply_count = 0;
+  client->unanswered_request_count = 0;
+  client->response_count = 0;
+  client->unexpected_reply_count = 0;
+  client->round_trip_time_last_us = 0;
+  client->round_trip_time_min_us = 0;
+  client->round_trip_time_max_us = 0;
+  client->round_trip_time_total_us = 0;
 
   if (rmw_zp_adapt_qos_profile(&client->adapted_qos_profile) != RMW_RET_OK) {
     return RMW_RET_ERROR;
   }
 
+  rmw_zp_data_callback_init(&client->data_callback, client->adapted_qos_profile.depth);
+
+#if RMW_ZP_HAVE_ATOMICS
+  atomic_init(&client->sequence_number, 1);
+  atomic_init(&client->num_in_flight, 0);
+#else
+  client->sequence_number = 1;
+  client->num_in_flight = 0;
+
   if (z_mutex_init(&client->sequence_number_mutex) < 0) {
     RMW_SET_ERROR_MSG("Failed to initialize zenohpico mutex");
     return RMW_RET_ERROR;
   }
+#endif
 
   if (z_mutex_init(&client->condition_mutex) < 0) {
     RMW_SET_ERROR_MSG("Failed to initialize zenohpico mutex");
@@ -29,93 +62,186 @@ rmw_ret_t rmw_zp_client_init(rmw_zp_client_t* client, const rmw_qos_profile_t* q
     goto fail_init_reply_queue;
   }
 
-  if (z_mutex_init(&client->reply_queue_mutex) < 0) {
-    RMW_SET_ERROR_MSG("Failed to initialize zenohpico mutex");
-    goto fail_init_reply_queue_mutex;
-  }
-
+#if !RMW_ZP_HAVE_ATOMICS
   if (z_mutex_init(&client->in_flight_mutex) < 0) {
     RMW_SET_ERROR_MSG("Failed to initialize zenohpico mutex");
     goto fail_init_in_flight_mutex;
   }
+#endif
 
   return RMW_RET_OK;
 
+#if !RMW_ZP_HAVE_ATOMICS
 fail_init_in_flight_mutex:
-  z_drop(z_move(client->reply_queue_mutex));
-fail_init_reply_queue_mutex:
   rmw_zp_message_queue_fini(&client->reply_queue, allocator);
+#endif
 fail_init_reply_queue:
   z_drop(z_move(client->condition_mutex));
 fail_init_condition_mutex:
+#if !RMW_ZP_HAVE_ATOMICS
   z_drop(z_move(client->sequence_number_mutex));
+#endif
   return RMW_RET_ERROR;
 }
 
 rmw_ret_t rmw_zp_client_fini(rmw_zp_client_t* client, rcutils_allocator_t* allocator) {
   rmw_ret_t ret = RMW_RET_OK;
 
+#if !RMW_ZP_HAVE_ATOMICS
   if (z_drop(z_move(client->in_flight_mutex)) < 0) {
     RMW_SET_ERROR_MSG("Failed to drop zenohpico mutex");
     ret = RMW_RET_ERROR;
   }
-
-  if (z_drop(z_move(client->reply_queue_mutex)) < 0) {
-    RMW_SET_ERROR_MSG("Failed to drop zenohpico mutex");
-    ret = RMW_RET_ERROR;
-  }
+#endif
 
   if (rmw_zp_message_queue_fini(&client->reply_queue, allocator) != RMW_RET_OK) {
     ret = RMW_RET_ERROR;
   }
 
+  rmw_zp_waitable_fini(&client->waitable, &client->condition_mutex);
+
   if (z_drop(z_move(client->condition_mutex)) < 0) {
     RMW_SET_ERROR_MSG("Failed to drop zenohpico mutex");
     ret = RMW_RET_ERROR;
   }
 
+#if !RMW_ZP_HAVE_ATOMICS
   if (z_drop(z_move(client->sequence_number_mutex)) < 0) {
     RMW_SET_ERROR_MSG("Failed to drop zenohpico mutex");
     ret = RMW_RET_ERROR;
   }
+#endif
 
   return ret;
 }
 
 size_t rmw_zp_client_get_next_sequence_number(rmw_zp_client_t* client) {
+#if RMW_ZP_HAVE_ATOMICS
+  return atomic_fetch_add_explicit(&client->sequence_number, 1, memory_order_relaxed);
+#else
   z_mutex_lock(z_loan_mut(client->sequence_number_mutex));
   size_t seq = client->sequence_number++;
   z_mutex_unlock(z_loan_mut(client->sequence_number_mutex));
   return seq;
+#endif
+}
+
+bool rmw_zp_client_shutdown(rmw_zp_client_t* client) {
+  z_mutex_lock(z_loan_mut(client->condition_mutex));
+  client->is_shutdown = true;
+  const bool queries_in_flight = rmw_zp_client_get_queries_in_flight(client) > 0;
+  z_mutex_unlock(z_loan_mut(client->condition_mutex));
+
+  return !queries_in_flight;
 }
 
-void rmw_zp_client_increment_queries_in_flight(rmw_zp_client_t* client) {
+bool rmw_zp_client_try_increment_queries_in_flight(rmw_zp_client_t* client) {
+  bool incremented;
+
+#if RMW_ZP_HAVE_ATOMICS
+  size_t num_in_flight = atomic_load_explicit(&client->num_in_flight, memory_order_relaxed);
+  do {
+    incremented = client->max_in_flight == 0 || num_in_flight < client->max_in_flight;
+  } while (incremented && !atomic_compare_exchange_weak_explicit(
+                              &client->num_in_flight, &num_in_flight, num_in_flight + 1,
+                              memory_order_relaxed, memory_order_relaxed));
+#else
   z_mutex_lock(z_loan_mut(client->in_flight_mutex));
-  client->num_in_flight++;
+  incremented = client->max_in_flight == 0 || client->num_in_flight < client->max_in_flight;
+  if (incremented) {
+    client->num_in_flight++;
+  }
   z_mutex_unlock(z_loan_mut(client->in_flight_mutex));
+#endif
+
+  if (!incremented) {
+    z_mutex_lock(z_loan_mut(client->condition_mutex));
+    client->rejected_request_count++;
+    z_mutex_unlock(z_loan_mut(client->condition_mutex));
+  }
+
+  return incremented;
 }
 
 void rmw_zp_client_decrement_queries_in_flight(rmw_zp_client_t* client, bool* queries_in_flight) {
+#if RMW_ZP_HAVE_ATOMICS
+  // Acquire-release so that whichever thread drops the count to zero, and may then free the
+  // client, observes every access made by the other query callbacks.
+  *queries_in_flight =
+      atomic_fetch_sub_explicit(&client->num_in_flight, 1, memory_order_acq_rel) - 1 > 0;
+#else
   z_mutex_lock(z_loan_mut(client->in_flight_mutex));
   *queries_in_flight = --client->num_in_flight > 0;
   z_mutex_unlock(z_loan_mut(client->in_flight_mutex));
+#endif
+}
+
+size_t rmw_zp_client_get_queries_in_flight(rmw_zp_client_t* client) {
+#if RMW_ZP_HAVE_ATOMICS
+  return atomic_load_explicit(&client->num_in_flight, memory_order_acquire);
+#else
+  z_mutex_lock(z_loan_mut(client->in_flight_mutex));
+  size_t num_in_flight = client->num_in_flight;
+  z_mutex_unlock(z_loan_mut(client->in_flight_mutex));
+  return num_in_flight;
+#endif
+}
+
+void rmw_zp_client_set_query_timeout(rmw_zp_client_t* client, size_t timeout_ms) {
+  z_mutex_lock(z_loan_mut(client->condition_mutex));
+  client->query_timeout_ms = to_query_timeout(timeout_ms);
+  z_mutex_unlock(z_loan_mut(client->condition_mutex));
+}
+
+void rmw_zp_client_set_query_target(rmw_zp_client_t* client, z_query_target_t target) {
+  z_mutex_lock(z_loan_mut(client->condition_mutex));
+  client->query_target = target;
+  z_mutex_unlock(z_loan_mut(client->condition_mutex));
+}
+
+void rmw_zp_client_set_query_consolidation(rmw_zp_client_t* client,
+                                           z_consolidation_mode_t consolidation) {
+  z_mutex_lock(z_loan_mut(client->condition_mutex));
+  client->query_consolidation = consolidation;
+  z_mutex_unlock(z_loan_mut(client->condition_mutex));
+}
+
+void rmw_zp_client_get_query_options(rmw_zp_client_t* client, z_get_options_t* options) {
+  z_get_options_default(options);
+
+  z_mutex_lock(z_loan_mut(client->condition_mutex));
+  options->target = client->query_target;
+  options->consolidation.mode = client->query_consolidation;
+  options->timeout_ms = client->query_timeout_ms;
+  z_mutex_unlock(z_loan_mut(client->condition_mutex));
 }
 
 void rmw_zp_client_data_handler(z_loaned_reply_t* reply, void* data) {
-  rmw_zp_client_t* client_data = data;
-  if (client_data == NULL) {
+  rmw_zp_client_query_t* query = data;
+  if (query == NULL) {
     // TODO(bjsowa): report error
     return;
   }
 
+  rmw_zp_client_t* client_data = query->client;
+  const bool is_ok = z_reply_is_ok(reply);
+
+  z_mutex_lock(z_loan_mut(client_data->condition_mutex));
+  const bool is_shutdown = client_data->is_shutdown;
+  // Errors from other servers after the reply was received do not fail the request.
+  if (!is_ok && !query->has_reply && !query->has_error_reply) {
+    client_data->error_reply_count++;
+  }
+  z_mutex_unlock(z_loan_mut(client_data->condition_mutex));
+
   // See the comment about the "num_in_flight" class variable in the
   // rmw_client_data_t class for why we need to do this.
-  if (client_data->is_shutdown) {
+  if (is_shutdown) {
     return;
   }
 
-  if (!z_reply_is_ok(reply)) {
-    // TODO(bjsowa): Report error
+  if (!is_ok) {
+    query->has_error_reply = true;
     return;
   }
 
@@ -129,53 +255,95 @@ void rmw_zp_client_data_handler(z_loaned_reply_t* reply, void* data) {
 
   const z_loaned_bytes_t* payload = z_sample_payload(sample);
 
-  if (rmw_zp_client_add_new_reply(client_data, attachment, payload) != RMW_RET_OK) {
+  if (rmw_zp_client_add_new_reply(client_data, query, attachment, payload) != RMW_RET_OK) {
     // TODO(bjsowa): report error
   }
 }
 
 void rmw_zp_client_data_dropper(void* data) {
-  rmw_zp_client_t* client_data = data;
-  if (client_data == NULL) {
+  rmw_zp_client_query_t* query = data;
+  if (query == NULL) {
     // TODO(bjsowa): report error
     return;
   }
 
+  rmw_zp_client_t* client_data = query->client;
+  // Copied, as the client may be freed below.
+  rcutils_allocator_t allocator = client_data->context->options.allocator;
+
+  z_mutex_lock(z_loan_mut(client_data->condition_mutex));
+
+  if (!query->has_reply && !query->has_error_reply) {
+    if (z_clock_elapsed_ms(&query->send_time) >= query->timeout_ms) {
+      client_data->timed_out_request_count++;
+    } else {
+      client_data->unanswered_request_count++;
+    }
+  }
+
   // See the comment about the "num_in_flight" class variable in the
   // rmw_client_data_t class for why we need to do this.
   bool queries_in_flight = false;
   rmw_zp_client_decrement_queries_in_flight(client_data, &queries_in_flight);
+  const bool is_last_reference = client_data->is_shutdown && !queries_in_flight;
 
-  if (client_data->is_shutdown) {
-    if (!queries_in_flight) {
-      rmw_zp_client_fini(client_data, &client_data->context->options.allocator);
-      client_data->context->options.allocator.deallocate(
-          client_data, client_data->context->options.allocator.state);
-    }
+  z_mutex_unlock(z_loan_mut(client_data->condition_mutex));
+
+  allocator.deallocate(query, allocator.state);
+
+  if (is_last_reference) {
+    rmw_zp_client_fini(client_data, &allocator);
+    allocator.deallocate(client_data, allocator.state);
   }
 }
 
-rmw_ret_t rmw_zp_client_add_new_reply(rmw_zp_client_t* client, const z_loaned_bytes_t* attachment,
-                                      const z_loaned_bytes_t* payload) {
-  z_mutex_lock(z_loan_mut(client->reply_queue_mutex));
-
-  if (client->reply_queue.size >= client->adapted_qos_profile.depth) {
-    // TODO(bjsowa): Log warning if reply is discarded due to hitting the queue depth
+static bool is_reply_to(const rmw_zp_client_t* client, const rmw_zp_client_query_t* query,
+                        const rmw_zp_attachment_data_t* attachment_data) {
+  return attachment_data->sequence_number == query->sequence_number &&
+         memcmp(attachment_data->source_gid, client->client_gid, RMW_GID_STORAGE_SIZE) == 0;
+}
 
-    // Adapted QoS has depth guaranteed to be >= 1
-    if (rmw_zp_message_queue_pop_front(&client->reply_queue, NULL) != RMW_RET_OK) {
-      z_mutex_unlock(z_loan_mut(client->reply_queue_mutex));
-      return RMW_RET_ERROR;
-    }
+static void record_round_trip_time(rmw_zp_client_t* client, uint64_t round_trip_time_us) {
+  z_mutex_lock(z_loan_mut(client->condition_mutex));
+  if (client->response_count == 0 || round_trip_time_us < client->round_trip_time_min_us) {
+    client->round_trip_time_min_us = round_trip_time_us;
   }
+  if (round_trip_time_us > client->round_trip_time_max_us) {
+    client->round_trip_time_max_us = round_trip_time_us;
+  }
+  client->round_trip_time_last_us = round_trip_time_us;
+  client->round_trip_time_total_us += round_trip_time_us;
+  client->response_count++;
+  z_mutex_unlock(z_loan_mut(client->condition_mutex));
+}
 
-  if (rmw_zp_message_queue_push_back(&client->reply_queue, attachment, payload, NULL) !=
-      RMW_RET_OK) {
-    z_mutex_unlock(z_loan_mut(client->reply_queue_mutex));
+rmw_ret_t rmw_zp_client_add_new_reply(rmw_zp_client_t* client, rmw_zp_client_query_t* query,
+                                      const z_loaned_bytes_t* attachment,
+                                      const z_loaned_bytes_t* payload) {
+  rmw_zp_message_t reply;
+  if (rmw_zp_message_init(&reply, attachment, payload) != RMW_RET_OK) {
     return RMW_RET_ERROR;
   }
 
-  z_mutex_unlock(z_loan_mut(client->reply_queue_mutex));
+  // Only the first reply to the request sent with this query is queued. Replies for another
+  // request or client, and further replies (e.g. from other service servers), are dropped before
+  // they can be taken and deserialized.
+  if (query->has_reply || !is_reply_to(client, query, &reply.attachment_data)) {
+    rmw_zp_message_fini(&reply);
+
+    z_mutex_lock(z_loan_mut(client->condition_mutex));
+    client->unexpected_reply_count++;
+    z_mutex_unlock(z_loan_mut(client->condition_mutex));
+
+    return RMW_RET_OK;
+  }
+
+  query->has_reply = true;
+  record_round_trip_time(client, z_clock_elapsed_us(&query->send_time));
+
+  if (rmw_zp_message_queue_push_back(&client->reply_queue, &reply, NULL)) {
+    // TODO(bjsowa): Log warning if reply is discarded due to hitting the queue depth
+  }
 
   rmw_zp_client_notify(client);
 
@@ -183,59 +351,42 @@ rmw_ret_t rmw_zp_client_add_new_reply(rmw_zp_client_t* client, const z_loaned_by
 }
 
 rmw_ret_t rmw_zp_client_pop_next_reply(rmw_zp_client_t* client, rmw_zp_message_t* reply_data) {
-  z_mutex_lock(z_loan_mut(client->reply_queue_mutex));
-
-  if (client->reply_queue.size == 0) {
+  if (!rmw_zp_message_queue_pop_front(&client->reply_queue, reply_data)) {
     RMW_SET_ERROR_MSG("Trying to pop message from empty message queue");
-    z_mutex_unlock(z_loan_mut(client->reply_queue_mutex));
-    return RMW_RET_ERROR;
-  }
-
-  if (rmw_zp_message_queue_pop_front(&client->reply_queue, reply_data) != RMW_RET_OK) {
-    z_mutex_unlock(z_loan_mut(client->reply_queue_mutex));
     return RMW_RET_ERROR;
   }
 
-  z_mutex_unlock(z_loan_mut(client->reply_queue_mutex));
-
   return RMW_RET_OK;
 }
 
-bool rmw_zp_client_queue_has_data_and_attach_condition_if_not(rmw_zp_client_t* client,
-                                                              rmw_zp_wait_set_t* wait_set) {
+rmw_ret_t rmw_zp_client_attach(rmw_zp_client_t* client, rmw_zp_wait_set_attachment_t* attachment) {
   z_mutex_lock(z_loan_mut(client->condition_mutex));
 
-  if (client->reply_queue.size > 0) {
-    z_mutex_unlock(z_loan_mut(client->condition_mutex));
-    return true;
-  }
-
-  client->wait_set_data = wait_set;
+  rmw_ret_t ret = rmw_zp_waitable_attach(&client->waitable, &client->condition_mutex, attachment,
+                                         rmw_zp_client_has_data(client));
 
   z_mutex_unlock(z_loan_mut(client->condition_mutex));
 
-  return false;
+  return ret;
+}
+
+bool rmw_zp_client_has_data(rmw_zp_client_t* client) {
+  return !rmw_zp_message_queue_is_empty(&client->reply_queue);
 }
 
 void rmw_zp_client_notify(rmw_zp_client_t* client) {
   z_mutex_lock(z_loan_mut(client->condition_mutex));
 
-  if (client->wait_set_data != NULL) {
-    z_mutex_lock(z_loan_mut(client->wait_set_data->condition_mutex));
-    client->wait_set_data->triggered = true;
-    z_condvar_signal(z_loan_mut(client->wait_set_data->condition_variable));
-    z_mutex_unlock(z_loan_mut(client->wait_set_data->condition_mutex));
-  }
+  rmw_zp_waitable_notify(&client->waitable);
+
+  rmw_zp_data_callback_trigger(&client->data_callback, 1);
 
   z_mutex_unlock(z_loan_mut(client->condition_mutex));
 }
 
-bool rmw_zp_client_detach_condition_and_queue_is_empty(rmw_zp_client_t* client) {
+void rmw_zp_client_set_data_callback(rmw_zp_client_t* client, rmw_event_callback_t callback,
+                                     const void* user_data) {
   z_mutex_lock(z_loan_mut(client->condition_mutex));
-
-  client->wait_set_data = NULL;
-
+  rmw_zp_data_callback_set(&client->data_callback, callback, user_data);
   z_mutex_unlock(z_loan_mut(client->condition_mutex));
-
-  return client->reply_queue.size == 0;
 }
\ No newline at end of file
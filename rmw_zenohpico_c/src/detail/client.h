@@ -1,9 +1,12 @@
 #ifndef RMW_ZENOHPICO_DETAIL__CLIENT_H_
 #define RMW_ZENOHPICO_DETAIL__CLIENT_H_
 
+#include <stdbool.h>
 #include <stdint.h>
 
+#include "./atomic.h"
 #include "./attachment_helpers.h"
+#include "./data_callback.h"
 #include "./message_queue.h"
 #include "./type_support.h"
 #include "./wait_set.h"
@@ -25,60 +28,138 @@ typedef struct {
 
   uint8_t client_gid[RMW_GID_STORAGE_SIZE];
 
+  // Attachment encoded once for client_gid, patched with the sequence number and timestamp of each
+  // request.
+  rmw_zp_attachment_template_t attachment_template;
+
+#if RMW_ZP_HAVE_ATOMICS
+  atomic_size_t sequence_number;
+#else
   z_owned_mutex_t sequence_number_mutex;
   size_t sequence_number;
+#endif
 
-  rmw_zp_wait_set_t* wait_set_data;
+  rmw_zp_waitable_t waitable;
   z_owned_mutex_t condition_mutex;
 
+  // Guarded by condition_mutex.
+  rmw_zp_data_callback_t data_callback;
+
   rmw_zp_message_queue_t reply_queue;
-  z_owned_mutex_t reply_queue_mutex;
 
   // rmw_zenoh uses Zenoh queries to implement clients.  It turns out that in Zenoh, there is no
   // way to cancel a query once it is in-flight via the z_get() zenoh-c API. Thus, if an
   // rmw_zenoh_cpp user does rmw_create_client(), rmw_send_request(), rmw_destroy_client(), but the
   // query comes in after the rmw_destroy_client(), rmw_zenoh_cpp could access already-freed memory.
   //
-  // The next 3 variables are used to avoid that situation.  Any time a query is initiated via
-  // rmw_send_request(), num_in_flight_ is incremented.  When the Zenoh calls the callback for the
-  // query reply, num_in_flight_ is decremented.  When rmw_destroy_client() is called, is_shutdown_
-  // is set to true.  If num_in_flight_ is 0, the data associated with this structure is freed.
-  // If num_in_flight_ is *not* 0, then the data associated with this structure is maintained.
-  // In the situation where is_shutdown_ is true, and num_in_flight_ drops to 0 in the query
-  // callback, the query callback will free up the structure.
+  // The next 2 variables are used to avoid that situation.  Any time a query is initiated via
+  // rmw_send_request(), num_in_flight is incremented.  When Zenoh drops the callbacks of the query,
+  // num_in_flight is decremented.  When rmw_destroy_client() is called, is_shutdown is set to
+  // true.  If num_in_flight is 0, the data associated with this structure is freed.  If
+  // num_in_flight is *not* 0, then the data associated with this structure is maintained, and the
+  // query callback that drops num_in_flight to 0 frees it.  Both decisions are taken with
+  // condition_mutex held, so that exactly one of them frees the structure.
   //
-  // There is one case which is not handled by this, which has to do with timeouts.  The query
-  // timeout is currently set to essentially infinite.  Thus, if a query is in-flight but never
-  // returns, the memory in this structure will never be freed.  There isn't much we can do about
-  // that at this time, but we may want to consider changing the timeout so that the memory can
-  // eventually be freed up.
-  z_owned_mutex_t in_flight_mutex;
+  // Queries that never get a reply are only dropped once they time out, after query_timeout_ms.
+  // At most max_in_flight queries (0 for no limit) are in flight at once, further requests fail
+  // right away.
   bool is_shutdown;
+#if RMW_ZP_HAVE_ATOMICS
+  atomic_size_t num_in_flight;
+#else
+  z_owned_mutex_t in_flight_mutex;
   size_t num_in_flight;
+#endif
+  size_t max_in_flight;
+
+  // Options of the queries sent for requests. Guarded by condition_mutex. UINT32_MAX for no
+  // timeout.
+  uint32_t query_timeout_ms;
+  z_query_target_t query_target;
+  z_consolidation_mode_t query_consolidation;
+
+  // Requests rejected because max_in_flight was reached, and requests that ended without a
+  // successful reply: because they timed out, because the service answered with an error reply,
+  // or because no service server answered them. Guarded by condition_mutex.
+  size_t rejected_request_count;
+  size_t timed_out_request_count;
+  size_t error_reply_count;
+  size_t unanswered_request_count;
+
+  // Replies queued to be taken, and replies dropped because they did not match the request of
+  // their query or were not the first reply to it. Guarded by condition_mutex.
+  size_t response_count;
+  size_t unexpected_reply_count;
+
+  // Time between sending a request and receiving its reply, over response_count requests. Guarded
+  // by condition_mutex.
+  uint64_t round_trip_time_last_us;
+  uint64_t round_trip_time_min_us;
+  uint64_t round_trip_time_max_us;
+  uint64_t round_trip_time_total_us;
 } rmw_zp_client_t;
 
+// State of a single query sent by rmw_send_request, passed to its callbacks. Replies are matched
+// against it, as each query carries exactly one request.
+typedef struct {
+  rmw_zp_client_t* client;
+  int64_t sequence_number;
+  z_clock_t send_time;
+  uint32_t timeout_ms;
+
+  // Only accessed by the query callbacks.
+  bool has_reply;
+  bool has_error_reply;
+} rmw_zp_client_query_t;
+
+// A query timeout of 0 means no timeout, a max_in_flight of 0 means no limit.
 rmw_ret_t rmw_zp_client_init(rmw_zp_client_t* client, const rmw_qos_profile_t* qos_profile,
+                             size_t query_timeout_ms, size_t max_in_flight,
+                             z_query_target_t query_target,
+                             z_consolidation_mode_t query_consolidation,
                              rcutils_allocator_t* allocator);
 
 rmw_ret_t rmw_zp_client_fini(rmw_zp_client_t* client, rcutils_allocator_t* allocator);
 
+// Mark the client as destroyed. Returns true if no query is in flight anymore, in which case the
+// caller has to finalize and free it. Otherwise the last query callback does.
+bool rmw_zp_client_shutdown(rmw_zp_client_t* client);
+
 size_t rmw_zp_client_get_next_sequence_number(rmw_zp_client_t* client);
-void rmw_zp_client_increment_queries_in_flight(rmw_zp_client_t* client);
+
+// Returns false, and counts a rejected request, if max_in_flight queries are already in flight.
+bool rmw_zp_client_try_increment_queries_in_flight(rmw_zp_client_t* client);
 void rmw_zp_client_decrement_queries_in_flight(rmw_zp_client_t* client, bool* queries_in_flight);
+size_t rmw_zp_client_get_queries_in_flight(rmw_zp_client_t* client);
+
+// Use timeout_ms for the queries sent from now on. 0 means no timeout.
+void rmw_zp_client_set_query_timeout(rmw_zp_client_t* client, size_t timeout_ms);
+
+// Use the target and consolidation mode for the queries sent from now on.
+void rmw_zp_client_set_query_target(rmw_zp_client_t* client, z_query_target_t target);
+void rmw_zp_client_set_query_consolidation(rmw_zp_client_t* client,
+                                           z_consolidation_mode_t consolidation);
+
+// Fill the options of a query for a new request, except its payload and attachment.
+void rmw_zp_client_get_query_options(rmw_zp_client_t* client, z_get_options_t* options);
 
 void rmw_zp_client_data_handler(z_loaned_reply_t* reply, void* data);
 void rmw_zp_client_data_dropper(void* data);
 
-rmw_ret_t rmw_zp_client_add_new_reply(rmw_zp_client_t* client, const z_loaned_bytes_t* attachment,
+// Queue the reply if it is the first one to the request of the query, otherwise drop it.
+rmw_ret_t rmw_zp_client_add_new_reply(rmw_zp_client_t* client, rmw_zp_client_query_t* query,
+                                      const z_loaned_bytes_t* attachment,
                                       const z_loaned_bytes_t* payload);
 
 rmw_ret_t rmw_zp_client_pop_next_reply(rmw_zp_client_t* client, rmw_zp_message_t* reply_data);
 
-bool rmw_zp_client_queue_has_data_and_attach_condition_if_not(rmw_zp_client_t* client,
-                                                              rmw_zp_wait_set_t* wait_set);
+rmw_ret_t rmw_zp_client_attach(rmw_zp_client_t* client, rmw_zp_wait_set_attachment_t* attachment);
+
+bool rmw_zp_client_has_data(rmw_zp_client_t* client);
 
 void rmw_zp_client_notify(rmw_zp_client_t* client);
 
-bool rmw_zp_client_detach_condition_and_queue_is_empty(rmw_zp_client_t* client);
+void rmw_zp_client_set_data_callback(rmw_zp_client_t* client, rmw_event_callback_t callback,
+                                     const void* user_data);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,183 @@
+#include "./config.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rcutils/env.h"
+#include "rmw/error_handling.h"
+
+static rmw_ret_t get_env_size(const char* env_var, size_t default_value, size_t* value) {
+  const char* env_value = NULL;
+  const char* error_str = rcutils_get_env(env_var, &env_value);
+  if (error_str != NULL) {
+    RMW_SET_ERROR_MSG_WITH_FORMAT_STRING("Failed to read %s: %s", env_var, error_str);
+    return RMW_RET_ERROR;
+  }
+
+  if (env_value == NULL || env_value[0] == '\0') {
+    *value = default_value;
+    return RMW_RET_OK;
+  }
+
+  char* end = NULL;
+  errno = 0;
+  unsigned long long parsed = strtoull(env_value, &end, 10);
+  if (errno != 0 || end == env_value || *end != '\0' || parsed > SIZE_MAX) {
+    RMW_SET_ERROR_MSG_WITH_FORMAT_STRING("Invalid value of %s: '%s'", env_var, env_value);
+    return RMW_RET_ERROR;
+  }
+
+  *value = (size_t)parsed;
+  return RMW_RET_OK;
+}
+
+typedef struct {
+  const char* name;
+  int value;
+} env_choice_t;
+
+// Set value to the one of the choice named by the environment variable, or to default_value if it
+// is not set.
+static rmw_ret_t get_env_choice(const char* env_var, const env_choice_t* choices,
+                                size_t choice_count, int default_value, int* value) {
+  const char* env_value = NULL;
+  const char* error_str = rcutils_get_env(env_var, &env_value);
+  if (error_str != NULL) {
+    RMW_SET_ERROR_MSG_WITH_FORMAT_STRING("Failed to read %s: %s", env_var, error_str);
+    return RMW_RET_ERROR;
+  }
+
+  if (env_value == NULL || env_value[0] == '\0') {
+    *value = default_value;
+    return RMW_RET_OK;
+  }
+
+  for (size_t i = 0; i < choice_count; i++) {
+    if (strcmp(env_value, choices[i].name) == 0) {
+      *value = choices[i].value;
+      return RMW_RET_OK;
+    }
+  }
+
+  RMW_SET_ERROR_MSG_WITH_FORMAT_STRING("Invalid value of %s: '%s'", env_var, env_value);
+  return RMW_RET_ERROR;
+}
+
+static rmw_ret_t get_env_attachment_format(const char* env_var,
+                                           rmw_zp_attachment_format_t default_value,
+                                           rmw_zp_attachment_format_t* value) {
+  static const env_choice_t choices[] = {
+      {"key_value", RMW_ZP_ATTACHMENT_FORMAT_KEY_VALUE},
+      {"compact", RMW_ZP_ATTACHMENT_FORMAT_COMPACT},
+  };
+
+  int choice;
+  if (get_env_choice(env_var, choices, sizeof(choices) / sizeof(choices[0]), (int)default_value,
+                     &choice) != RMW_RET_OK) {
+    return RMW_RET_ERROR;
+  }
+
+  *value = (rmw_zp_attachment_format_t)choice;
+  return RMW_RET_OK;
+}
+
+static rmw_ret_t get_env_query_target(const char* env_var, z_query_target_t default_value,
+                                      z_query_target_t* value) {
+  static const env_choice_t choices[] = {
+      {"best_matching", Z_QUERY_TARGET_BEST_MATCHING},
+      {"all", Z_QUERY_TARGET_ALL},
+      {"all_complete", Z_QUERY_TARGET_ALL_COMPLETE},
+  };
+
+  int choice;
+  if (get_env_choice(env_var, choices, sizeof(choices) / sizeof(choices[0]), (int)default_value,
+                     &choice) != RMW_RET_OK) {
+    return RMW_RET_ERROR;
+  }
+
+  *value = (z_query_target_t)choice;
+  return RMW_RET_OK;
+}
+
+static rmw_ret_t get_env_query_consolidation(const char* env_var,
+                                             z_consolidation_mode_t default_value,
+                                             z_consolidation_mode_t* value) {
+  static const env_choice_t choices[] = {
+      {"auto", Z_CONSOLIDATION_MODE_AUTO},
+      {"none", Z_CONSOLIDATION_MODE_NONE},
+      {"monotonic", Z_CONSOLIDATION_MODE_MONOTONIC},
+      {"latest", Z_CONSOLIDATION_MODE_LATEST},
+  };
+
+  int choice;
+  if (get_env_choice(env_var, choices, sizeof(choices) / sizeof(choices[0]), (int)default_value,
+                     &choice) != RMW_RET_OK) {
+    return RMW_RET_ERROR;
+  }
+
+  *value = (z_consolidation_mode_t)choice;
+  return RMW_RET_OK;
+}
+
+rmw_ret_t rmw_zp_config_init_from_env(rmw_zp_config_t* config) {
+  if (get_env_size(RMW_ZENOHPICO_SERIALIZATION_BUFFER_MAX_SIZE_ENV_VAR,
+                   RMW_ZENOHPICO_DEFAULT_SERIALIZATION_BUFFER_MAX_SIZE,
+                   &config->serialization_buffer_max_size) != RMW_RET_OK) {
+    return RMW_RET_ERROR;
+  }
+
+  if (get_env_attachment_format(RMW_ZENOHPICO_ATTACHMENT_FORMAT_ENV_VAR,
+                                RMW_ZP_ATTACHMENT_FORMAT_KEY_VALUE,
+                                &config->attachment_format) != RMW_RET_OK) {
+    return RMW_RET_ERROR;
+  }
+
+  if (get_env_size(RMW_ZENOHPICO_WAIT_SPIN_PERIOD_US_ENV_VAR, 0, &config->wait_spin_period_us) !=
+      RMW_RET_OK) {
+    return RMW_RET_ERROR;
+  }
+
+  if (get_env_size(RMW_ZENOHPICO_TIMER_WHEEL_TICK_US_ENV_VAR,
+                   RMW_ZENOHPICO_DEFAULT_TIMER_WHEEL_TICK_US,
+                   &config->timer_wheel_tick_us) != RMW_RET_OK) {
+    return RMW_RET_ERROR;
+  }
+
+  if (config->timer_wheel_tick_us == 0) {
+    RMW_SET_ERROR_MSG_WITH_FORMAT_STRING("%s must be greater than 0",
+                                         RMW_ZENOHPICO_TIMER_WHEEL_TICK_US_ENV_VAR);
+    return RMW_RET_ERROR;
+  }
+
+  if (get_env_size(RMW_ZENOHPICO_SERVICE_MAX_PENDING_QUERIES_ENV_VAR,
+                   RMW_ZENOHPICO_DEFAULT_SERVICE_MAX_PENDING_QUERIES,
+                   &config->service_max_pending_queries) != RMW_RET_OK) {
+    return RMW_RET_ERROR;
+  }
+
+  if (get_env_size(RMW_ZENOHPICO_CLIENT_QUERY_TIMEOUT_MS_ENV_VAR, 0,
+                   &config->client_query_timeout_ms) != RMW_RET_OK) {
+    return RMW_RET_ERROR;
+  }
+
+  if (get_env_size(RMW_ZENOHPICO_CLIENT_MAX_IN_FLIGHT_ENV_VAR,
+                   RMW_ZENOHPICO_DEFAULT_CLIENT_MAX_IN_FLIGHT,
+                   &config->client_max_in_flight) != RMW_RET_OK) {
+    return RMW_RET_ERROR;
+  }
+
+  if (get_env_query_target(RMW_ZENOHPICO_CLIENT_QUERY_TARGET_ENV_VAR, Z_QUERY_TARGET_ALL_COMPLETE,
+                           &config->client_query_target) != RMW_RET_OK) {
+    return RMW_RET_ERROR;
+  }
+
+  if (get_env_query_consolidation(RMW_ZENOHPICO_CLIENT_QUERY_CONSOLIDATION_ENV_VAR,
+                                  Z_CONSOLIDATION_MODE_LATEST,
+                                  &config->client_query_consolidation) != RMW_RET_OK) {
+    return RMW_RET_ERROR;
+  }
+
+  return RMW_RET_OK;
+}
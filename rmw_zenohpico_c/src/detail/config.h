@@ -0,0 +1,78 @@
+#ifndef RMW_ZENOHPICO_DETAIL__CONFIG_H_
+#define RMW_ZENOHPICO_DETAIL__CONFIG_H_
+
+#include <stddef.h>
+
+#include "./attachment_helpers.h"
+#include "rmw/ret_types.h"
+#include "zenoh-pico.h"
+
+// Maximum size (in bytes) of the serialization buffer that each publisher keeps around between
+// publications. Messages that serialize to more than this are written into a one-off allocation.
+#define RMW_ZENOHPICO_SERIALIZATION_BUFFER_MAX_SIZE_ENV_VAR \
+  "RMW_ZENOHPICO_SERIALIZATION_BUFFER_MAX_SIZE"
+#define RMW_ZENOHPICO_DEFAULT_SERIALIZATION_BUFFER_MAX_SIZE 65536
+
+// Format of the attachments sent with messages, requests and responses: "key_value" (the default,
+// understood by rmw_zenoh_cpp) or "compact". Received attachments are accepted in either format,
+// so nodes using different formats interoperate as long as all of them run rmw_zenohpico_c.
+#define RMW_ZENOHPICO_ATTACHMENT_FORMAT_ENV_VAR "RMW_ZENOHPICO_ATTACHMENT_FORMAT"
+
+// Time (in microseconds) rmw_wait() polls for ready entities before blocking on a condition
+// variable. Spinning avoids the cost of being woken up by another thread, at the expense of a busy
+// CPU. 0 (the default) disables it. Can be changed per wait set with
+// rmw_zenohpico_wait_set_set_spin_period.
+#define RMW_ZENOHPICO_WAIT_SPIN_PERIOD_US_ENV_VAR "RMW_ZENOHPICO_WAIT_SPIN_PERIOD_US"
+
+// Resolution (in microseconds) of the timer wheel of each context, which detects missed deadlines.
+// Deadline misses are reported up to one tick late. Defaults to 1000.
+#define RMW_ZENOHPICO_TIMER_WHEEL_TICK_US_ENV_VAR "RMW_ZENOHPICO_TIMER_WHEEL_TICK_US"
+#define RMW_ZENOHPICO_DEFAULT_TIMER_WHEEL_TICK_US 1000
+
+// Maximum number of queries a service holds on to at once, i.e. requests that were received but not
+// responded to yet, whether they were taken or not. Requests beyond that are rejected right away
+// with an error reply. 0 means no limit. Independent of the depth of the request queue: requests
+// dropped from a full queue are answered with an error reply as well.
+#define RMW_ZENOHPICO_SERVICE_MAX_PENDING_QUERIES_ENV_VAR \
+  "RMW_ZENOHPICO_SERVICE_MAX_PENDING_QUERIES"
+#define RMW_ZENOHPICO_DEFAULT_SERVICE_MAX_PENDING_QUERIES 1024
+
+// Time (in milliseconds) after which a request that got no reply is given up on, releasing the
+// memory held for it. 0 (the default) means no timeout, as actions may take arbitrarily long to
+// complete. Can be changed per client with rmw_zenohpico_client_set_query_timeout.
+#define RMW_ZENOHPICO_CLIENT_QUERY_TIMEOUT_MS_ENV_VAR "RMW_ZENOHPICO_CLIENT_QUERY_TIMEOUT_MS"
+
+// Maximum number of requests a client has in flight at once. rmw_send_request() fails right away
+// beyond that. 0 (the default) means no limit. Only set it along with a query timeout: requests to
+// a server that went away stay in flight until they time out, so without a timeout they would fill
+// the limit for good and every later request would fail.
+#define RMW_ZENOHPICO_CLIENT_MAX_IN_FLIGHT_ENV_VAR "RMW_ZENOHPICO_CLIENT_MAX_IN_FLIGHT"
+#define RMW_ZENOHPICO_DEFAULT_CLIENT_MAX_IN_FLIGHT 0
+
+// Queryables a request is sent to: "best_matching", "all" or "all_complete" (the default). Can be
+// changed per client with rmw_zenohpico_client_set_query_target.
+#define RMW_ZENOHPICO_CLIENT_QUERY_TARGET_ENV_VAR "RMW_ZENOHPICO_CLIENT_QUERY_TARGET"
+
+// Consolidation of the replies to a request: "auto", "none", "monotonic" or "latest" (the
+// default). "latest" makes routers hold back replies until the query is complete, "none" and
+// "monotonic" forward them right away, which lowers the latency of services with a single server.
+// Only the first reply to each request is taken either way. Can be changed per client with
+// rmw_zenohpico_client_set_query_consolidation.
+#define RMW_ZENOHPICO_CLIENT_QUERY_CONSOLIDATION_ENV_VAR "RMW_ZENOHPICO_CLIENT_QUERY_CONSOLIDATION"
+
+typedef struct {
+  size_t serialization_buffer_max_size;
+  rmw_zp_attachment_format_t attachment_format;
+  size_t wait_spin_period_us;
+  size_t timer_wheel_tick_us;
+  size_t service_max_pending_queries;
+  size_t client_query_timeout_ms;
+  size_t client_max_in_flight;
+  z_query_target_t client_query_target;
+  z_consolidation_mode_t client_query_consolidation;
+} rmw_zp_config_t;
+
+// Fill the config with the defaults, overridden by any RMW_ZENOHPICO_* environment variables.
+rmw_ret_t rmw_zp_config_init_from_env(rmw_zp_config_t* config);
+
+#endif
@@ -0,0 +1,36 @@
+#include "./data_callback.h"
+
+void rmw_zp_data_callback_init(rmw_zp_data_callback_t* data_callback, size_t max_unread_count) {
+  data_callback->callback = NULL;
+  data_callback->user_data = NULL;
+  data_callback->unread_count = 0;
+  data_callback->max_unread_count = max_unread_count;
+}
+
+void rmw_zp_data_callback_set(rmw_zp_data_callback_t* data_callback, rmw_event_callback_t callback,
+                              const void* user_data) {
+  if (callback == NULL) {
+    data_callback->callback = NULL;
+    data_callback->user_data = NULL;
+    return;
+  }
+
+  // The backlog is delivered right away, as required by the rmw API.
+  if (data_callback->unread_count > 0) {
+    callback(user_data, data_callback->unread_count);
+    data_callback->unread_count = 0;
+  }
+
+  data_callback->callback = callback;
+  data_callback->user_data = user_data;
+}
+
+void rmw_zp_data_callback_trigger(rmw_zp_data_callback_t* data_callback, size_t count) {
+  if (data_callback->callback != NULL) {
+    data_callback->callback(data_callback->user_data, count);
+  } else if (count < data_callback->max_unread_count - data_callback->unread_count) {
+    data_callback->unread_count += count;
+  } else {
+    data_callback->unread_count = data_callback->max_unread_count;
+  }
+}
@@ -0,0 +1,29 @@
+#ifndef RMW_ZENOHPICO_DETAIL__DATA_CALLBACK_H_
+#define RMW_ZENOHPICO_DETAIL__DATA_CALLBACK_H_
+
+#include <stddef.h>
+
+#include "rmw/event_callback_type.h"
+
+// Callback registered through rmw_*_set_on_new_*_callback, as used by the events executor. It is
+// not thread-safe on its own: the owning entity calls every function while holding its own mutex.
+typedef struct {
+  rmw_event_callback_t callback;
+  const void* user_data;
+
+  // Data that arrived while no callback was set. It is reported as soon as one is, but never as
+  // more than max_unread_count, the depth of the queue that keeps the data and drops the oldest.
+  size_t unread_count;
+  size_t max_unread_count;
+} rmw_zp_data_callback_t;
+
+void rmw_zp_data_callback_init(rmw_zp_data_callback_t* data_callback, size_t max_unread_count);
+
+// Passing a NULL callback unregisters the current one.
+void rmw_zp_data_callback_set(rmw_zp_data_callback_t* data_callback, rmw_event_callback_t callback,
+                              const void* user_data);
+
+// Report `count` new messages, requests, responses or events.
+void rmw_zp_data_callback_trigger(rmw_zp_data_callback_t* data_callback, size_t count);
+
+#endif
\ No newline at end of file
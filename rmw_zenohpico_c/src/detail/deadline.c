@@ -0,0 +1,88 @@
+#include "./deadline.h"
+
+#include <stddef.h>
+
+// Timers are the first member of rmw_zp_deadline_t.
+static bool on_timer_expired(rmw_zp_timer_t* timer, uint64_t now_us, uint64_t* expiry_us) {
+  rmw_zp_deadline_t* deadline = (rmw_zp_deadline_t*)timer;
+
+#if RMW_ZP_HAVE_ATOMICS
+  uint64_t last_activity_us =
+      atomic_load_explicit(&deadline->last_activity_us, memory_order_relaxed);
+#else
+  uint64_t last_activity_us = deadline->last_activity_us;
+#endif
+
+  uint64_t period_start_us = last_activity_us > deadline->missed_until_us
+                                 ? last_activity_us
+                                 : deadline->missed_until_us;
+
+  if (now_us >= period_start_us + deadline->period_us) {
+    // A single expiry may cover several periods when the deadline is shorter than a tick.
+    uint64_t missed = (now_us - period_start_us) / deadline->period_us;
+    period_start_us += missed * deadline->period_us;
+    deadline->missed_until_us = period_start_us;
+    rmw_zp_events_add(deadline->events, deadline->event_type, (size_t)missed);
+  }
+
+  *expiry_us = period_start_us + deadline->period_us;
+  return true;
+}
+
+void rmw_zp_deadline_init(rmw_zp_deadline_t* deadline, rmw_zp_timer_wheel_t* wheel,
+                          rmw_time_t period, rmw_zp_events_t* events,
+                          rmw_zp_event_type_t event_type) {
+  rmw_zp_timer_init(&deadline->timer, on_timer_expired);
+  deadline->events = events;
+  deadline->event_type = event_type;
+
+  if (rmw_time_equal(period, (rmw_time_t)RMW_DURATION_INFINITE) ||
+      rmw_time_equal(period, (rmw_time_t)RMW_DURATION_UNSPECIFIED)) {
+    deadline->wheel = NULL;
+    deadline->period_us = 0;
+    deadline->missed_until_us = 0;
+#if RMW_ZP_HAVE_ATOMICS
+    atomic_init(&deadline->last_activity_us, 0);
+#else
+    deadline->last_activity_us = 0;
+#endif
+    return;
+  }
+
+  uint64_t period_us = (uint64_t)rmw_time_total_nsec(period) / 1000;
+
+  // The deadline starts when the entity is created.
+  uint64_t now_us = rmw_zp_timer_wheel_now_us(wheel);
+  deadline->wheel = wheel;
+  deadline->period_us = period_us > 0 ? period_us : 1;
+  deadline->missed_until_us = now_us;
+#if RMW_ZP_HAVE_ATOMICS
+  atomic_init(&deadline->last_activity_us, now_us);
+#else
+  deadline->last_activity_us = now_us;
+#endif
+
+  rmw_zp_timer_wheel_arm(wheel, &deadline->timer, now_us + deadline->period_us);
+}
+
+void rmw_zp_deadline_fini(rmw_zp_deadline_t* deadline) {
+  if (deadline->wheel != NULL) {
+    rmw_zp_timer_wheel_disarm(deadline->wheel, &deadline->timer);
+  }
+}
+
+void rmw_zp_deadline_record_activity(rmw_zp_deadline_t* deadline) {
+  if (deadline->wheel == NULL) {
+    return;
+  }
+
+  uint64_t now_us = rmw_zp_timer_wheel_now_us(deadline->wheel);
+
+#if RMW_ZP_HAVE_ATOMICS
+  atomic_store_explicit(&deadline->last_activity_us, now_us, memory_order_relaxed);
+#else
+  z_mutex_lock(z_loan_mut(deadline->wheel->mutex));
+  deadline->last_activity_us = now_us;
+  z_mutex_unlock(z_loan_mut(deadline->wheel->mutex));
+#endif
+}
\ No newline at end of file
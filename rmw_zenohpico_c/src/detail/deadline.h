@@ -0,0 +1,48 @@
+#ifndef RMW_ZENOHPICO_DETAIL__DEADLINE_H_
+#define RMW_ZENOHPICO_DETAIL__DEADLINE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "./atomic.h"
+#include "./events.h"
+#include "./timer_wheel.h"
+#include "rmw/ret_types.h"
+#include "rmw/time.h"
+
+// Deadline QoS of a publisher or subscription. Every publication or reception only records when it
+// happened. The timer of the entity expires one deadline after the last activity it knows of, and
+// either reports the periods that went by without activity, or moves on to the latest activity.
+typedef struct {
+  rmw_zp_timer_t timer;
+
+  // NULL if the deadline is infinite.
+  rmw_zp_timer_wheel_t* wheel;
+  uint64_t period_us;
+
+  rmw_zp_events_t* events;
+  rmw_zp_event_type_t event_type;
+
+#if RMW_ZP_HAVE_ATOMICS
+  atomic_uint_fast64_t last_activity_us;
+#else
+  // Guarded by the mutex of the wheel.
+  uint64_t last_activity_us;
+#endif
+
+  // End of the last period reported as missed. Only accessed by the timer callback.
+  uint64_t missed_until_us;
+} rmw_zp_deadline_t;
+
+// Start monitoring the deadline, reporting misses as `event_type` events. An infinite (or zero)
+// deadline is never missed.
+void rmw_zp_deadline_init(rmw_zp_deadline_t* deadline, rmw_zp_timer_wheel_t* wheel,
+                          rmw_time_t period, rmw_zp_events_t* events,
+                          rmw_zp_event_type_t event_type);
+
+void rmw_zp_deadline_fini(rmw_zp_deadline_t* deadline);
+
+// Record a publication or reception.
+void rmw_zp_deadline_record_activity(rmw_zp_deadline_t* deadline);
+
+#endif
\ No newline at end of file
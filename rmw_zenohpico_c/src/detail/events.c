@@ -0,0 +1,135 @@
+#include "./events.h"
+
+#include <stdint.h>
+
+#include "rmw/error_handling.h"
+
+bool rmw_zp_event_type_from_rmw(rmw_event_type_t rmw_event_type, rmw_zp_event_type_t* event_type) {
+  switch (rmw_event_type) {
+    case RMW_EVENT_MESSAGE_LOST:
+      *event_type = RMW_ZP_EVENT_MESSAGE_LOST;
+      return true;
+    case RMW_EVENT_REQUESTED_DEADLINE_MISSED:
+      *event_type = RMW_ZP_EVENT_REQUESTED_DEADLINE_MISSED;
+      return true;
+    case RMW_EVENT_OFFERED_DEADLINE_MISSED:
+      *event_type = RMW_ZP_EVENT_OFFERED_DEADLINE_MISSED;
+      return true;
+    default:
+      return false;
+  }
+}
+
+rmw_ret_t rmw_zp_events_init(rmw_zp_events_t* events) {
+  for (size_t i = 0; i < RMW_ZP_EVENT_TYPE_COUNT; i++) {
+    rmw_zp_event_status_t* status = &events->statuses[i];
+#if RMW_ZP_HAVE_ATOMICS
+    atomic_init(&status->total_count, 0);
+    atomic_init(&status->total_count_change, 0);
+#else
+    status->total_count = 0;
+    status->total_count_change = 0;
+#endif
+    rmw_zp_waitable_init(&status->waitable);
+    // Events are counted rather than queued, so all of them can be taken.
+    rmw_zp_data_callback_init(&status->callback, SIZE_MAX);
+  }
+
+  if (z_mutex_init(&events->mutex) < 0) {
+    RMW_SET_ERROR_MSG("Failed to initialize zenohpico mutex");
+    return RMW_RET_ERROR;
+  }
+
+  return RMW_RET_OK;
+}
+
+rmw_ret_t rmw_zp_events_fini(rmw_zp_events_t* events) {
+  for (size_t i = 0; i < RMW_ZP_EVENT_TYPE_COUNT; i++) {
+    rmw_zp_waitable_fini(&events->statuses[i].waitable, &events->mutex);
+  }
+
+  if (z_drop(z_move(events->mutex)) < 0) {
+    RMW_SET_ERROR_MSG("Failed to drop zenohpico mutex");
+    return RMW_RET_ERROR;
+  }
+
+  return RMW_RET_OK;
+}
+
+void rmw_zp_events_add(rmw_zp_events_t* events, rmw_zp_event_type_t event_type, size_t count) {
+  rmw_zp_event_status_t* status = &events->statuses[event_type];
+
+  z_mutex_lock(z_loan_mut(events->mutex));
+
+#if RMW_ZP_HAVE_ATOMICS
+  atomic_fetch_add_explicit(&status->total_count, count, memory_order_relaxed);
+  atomic_fetch_add_explicit(&status->total_count_change, count, memory_order_relaxed);
+#else
+  status->total_count += count;
+  status->total_count_change += count;
+#endif
+
+  rmw_zp_waitable_notify(&status->waitable);
+  rmw_zp_data_callback_trigger(&status->callback, count);
+
+  z_mutex_unlock(z_loan_mut(events->mutex));
+}
+
+// Must be called with the mutex held, unless atomics are available.
+static bool status_has_event(rmw_zp_event_status_t* status) {
+#if RMW_ZP_HAVE_ATOMICS
+  return atomic_load_explicit(&status->total_count_change, memory_order_relaxed) > 0;
+#else
+  return status->total_count_change > 0;
+#endif
+}
+
+bool rmw_zp_events_has_event(rmw_zp_events_t* events, rmw_zp_event_type_t event_type) {
+#if RMW_ZP_HAVE_ATOMICS
+  return status_has_event(&events->statuses[event_type]);
+#else
+  z_mutex_lock(z_loan_mut(events->mutex));
+  bool has_event = status_has_event(&events->statuses[event_type]);
+  z_mutex_unlock(z_loan_mut(events->mutex));
+  return has_event;
+#endif
+}
+
+void rmw_zp_events_take(rmw_zp_events_t* events, rmw_zp_event_type_t event_type,
+                        size_t* total_count, size_t* total_count_change) {
+  rmw_zp_event_status_t* status = &events->statuses[event_type];
+
+  z_mutex_lock(z_loan_mut(events->mutex));
+
+#if RMW_ZP_HAVE_ATOMICS
+  *total_count = atomic_load_explicit(&status->total_count, memory_order_relaxed);
+  *total_count_change = atomic_exchange_explicit(&status->total_count_change, 0,
+                                                 memory_order_relaxed);
+#else
+  *total_count = status->total_count;
+  *total_count_change = status->total_count_change;
+  status->total_count_change = 0;
+#endif
+
+  z_mutex_unlock(z_loan_mut(events->mutex));
+}
+
+rmw_ret_t rmw_zp_events_attach(rmw_zp_events_t* events, rmw_zp_event_type_t event_type,
+                               rmw_zp_wait_set_attachment_t* attachment) {
+  z_mutex_lock(z_loan_mut(events->mutex));
+
+  rmw_zp_event_status_t* status = &events->statuses[event_type];
+  rmw_ret_t ret = rmw_zp_waitable_attach(&status->waitable, &events->mutex, attachment,
+                                         status_has_event(status));
+
+  z_mutex_unlock(z_loan_mut(events->mutex));
+
+  return ret;
+}
+
+void rmw_zp_events_set_callback(rmw_zp_events_t* events, rmw_zp_event_type_t event_type,
+                                rmw_event_callback_t callback, const void* user_data) {
+  z_mutex_lock(z_loan_mut(events->mutex));
+  rmw_zp_data_callback_set(&events->statuses[event_type].callback, callback, user_data);
+  z_mutex_unlock(z_loan_mut(events->mutex));
+}
\ No newline at end of file
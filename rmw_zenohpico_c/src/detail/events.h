@@ -0,0 +1,64 @@
+#ifndef RMW_ZENOHPICO_DETAIL__EVENTS_H_
+#define RMW_ZENOHPICO_DETAIL__EVENTS_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "./atomic.h"
+#include "./data_callback.h"
+#include "./wait_set.h"
+#include "rmw/event.h"
+#include "rmw/ret_types.h"
+#include "zenoh-pico.h"
+
+typedef enum {
+  RMW_ZP_EVENT_MESSAGE_LOST,
+  RMW_ZP_EVENT_REQUESTED_DEADLINE_MISSED,
+  RMW_ZP_EVENT_OFFERED_DEADLINE_MISSED,
+  RMW_ZP_EVENT_TYPE_COUNT,
+} rmw_zp_event_type_t;
+
+typedef struct {
+  // Number of events since the entity was created, and since the status was last taken.
+#if RMW_ZP_HAVE_ATOMICS
+  // Only modified with the mutex of rmw_zp_events_t held, but read without it by rmw_wait().
+  atomic_size_t total_count;
+  atomic_size_t total_count_change;
+#else
+  size_t total_count;
+  size_t total_count_change;
+#endif
+
+  rmw_zp_waitable_t waitable;
+  rmw_zp_data_callback_t callback;
+} rmw_zp_event_status_t;
+
+// QoS events of a publisher or subscription, as used by rmw_event_t.
+typedef struct {
+  z_owned_mutex_t mutex;
+  rmw_zp_event_status_t statuses[RMW_ZP_EVENT_TYPE_COUNT];
+} rmw_zp_events_t;
+
+// Returns false for events that are not supported.
+bool rmw_zp_event_type_from_rmw(rmw_event_type_t rmw_event_type, rmw_zp_event_type_t* event_type);
+
+rmw_ret_t rmw_zp_events_init(rmw_zp_events_t* events);
+
+rmw_ret_t rmw_zp_events_fini(rmw_zp_events_t* events);
+
+// Record `count` new events of the given type, waking up wait sets and calling the callback.
+void rmw_zp_events_add(rmw_zp_events_t* events, rmw_zp_event_type_t event_type, size_t count);
+
+bool rmw_zp_events_has_event(rmw_zp_events_t* events, rmw_zp_event_type_t event_type);
+
+// Take the counters of the given type, resetting total_count_change.
+void rmw_zp_events_take(rmw_zp_events_t* events, rmw_zp_event_type_t event_type,
+                        size_t* total_count, size_t* total_count_change);
+
+rmw_ret_t rmw_zp_events_attach(rmw_zp_events_t* events, rmw_zp_event_type_t event_type,
+                               rmw_zp_wait_set_attachment_t* attachment);
+
+void rmw_zp_events_set_callback(rmw_zp_events_t* events, rmw_zp_event_type_t event_type,
+                                rmw_event_callback_t callback, const void* user_data);
+
+#endif
\ No newline at end of file
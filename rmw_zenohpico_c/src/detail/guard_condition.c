@@ -4,7 +4,7 @@
 
 rmw_ret_t rmw_zp_guard_condition_init(rmw_zp_guard_condition_t* guard_condition) {
   guard_condition->has_triggered = false;
-  guard_condition->wait_set = NULL;
+  rmw_zp_waitable_init(&guard_condition->waitable);
 
   if (z_mutex_init(&guard_condition->internal_mutex) < 0) {
     RMW_SET_ERROR_MSG("Failed to initialize zenohpico mutex");
@@ -15,6 +15,8 @@ rmw_ret_t rmw_zp_guard_condition_init(rmw_zp_guard_condition_t* guard_condition)
 }
 
 rmw_ret_t rmw_zp_guard_condition_fini(rmw_zp_guard_condition_t* guard_condition) {
+  rmw_zp_waitable_fini(&guard_condition->waitable, &guard_condition->internal_mutex);
+
   if (z_drop(z_move(guard_condition->internal_mutex)) < 0) {
     RMW_SET_ERROR_MSG("Failed to drop zenohpico mutex");
     return RMW_RET_ERROR;
@@ -31,47 +33,29 @@ rmw_ret_t rmw_zp_guard_condition_trigger(rmw_zp_guard_condition_t* guard_conditi
   // be called
   guard_condition->has_triggered = true;
 
-  if (guard_condition->wait_set != NULL) {
-    z_mutex_lock(z_loan_mut(guard_condition->wait_set->condition_mutex));
-
-    guard_condition->wait_set->triggered = true;
-    
-    if (z_condvar_signal(z_loan_mut(guard_condition->wait_set->condition_variable)) < 0) {
-      RMW_SET_ERROR_MSG("Failed to signal condition variable.");
-      z_mutex_unlock(z_loan_mut(guard_condition->wait_set->condition_mutex));
-      z_mutex_unlock(z_loan_mut(guard_condition->internal_mutex));
-      return RMW_RET_ERROR;
-    }
-
-    z_mutex_unlock(z_loan_mut(guard_condition->wait_set->condition_mutex));
-  }
+  rmw_zp_waitable_notify(&guard_condition->waitable);
 
   z_mutex_unlock(z_loan_mut(guard_condition->internal_mutex));
 
   return RMW_RET_OK;
 }
 
-bool rmw_zp_guard_condition_check_and_attach_condition_if_not(
-    rmw_zp_guard_condition_t* guard_condition, rmw_zp_wait_set_t* wait_set) {
+rmw_ret_t rmw_zp_guard_condition_attach(rmw_zp_guard_condition_t* guard_condition,
+                                        rmw_zp_wait_set_attachment_t* attachment) {
   z_mutex_lock(z_loan_mut(guard_condition->internal_mutex));
 
-  if (guard_condition->has_triggered) {
-    return true;
-  }
-
-  guard_condition->wait_set = wait_set;
+  rmw_ret_t ret =
+      rmw_zp_waitable_attach(&guard_condition->waitable, &guard_condition->internal_mutex,
+                             attachment, guard_condition->has_triggered);
 
   z_mutex_unlock(z_loan_mut(guard_condition->internal_mutex));
 
-  return false;
+  return ret;
 }
 
-bool rmw_zp_guard_condition_detach_condition_and_is_trigger_set(
-    rmw_zp_guard_condition_t* guard_condition) {
+bool rmw_zp_guard_condition_take_trigger(rmw_zp_guard_condition_t* guard_condition) {
   z_mutex_lock(z_loan_mut(guard_condition->internal_mutex));
 
-  guard_condition->wait_set = NULL;
-
   bool ret = guard_condition->has_triggered;
 
   guard_condition->has_triggered = false;
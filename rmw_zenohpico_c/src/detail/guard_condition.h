@@ -10,7 +10,7 @@
 typedef struct {
   z_owned_mutex_t internal_mutex;
   bool has_triggered;
-  rmw_zp_wait_set_t* wait_set;
+  rmw_zp_waitable_t waitable;
 } rmw_zp_guard_condition_t;
 
 rmw_ret_t rmw_zp_guard_condition_init(rmw_zp_guard_condition_t* guard_condition);
@@ -19,10 +19,10 @@ rmw_ret_t rmw_zp_guard_condition_fini(rmw_zp_guard_condition_t* guard_condition)
 
 rmw_ret_t rmw_zp_guard_condition_trigger(rmw_zp_guard_condition_t* guard_condition);
 
-bool rmw_zp_guard_condition_check_and_attach_condition_if_not(
-    rmw_zp_guard_condition_t* guard_condition, rmw_zp_wait_set_t* wait_set);
+rmw_ret_t rmw_zp_guard_condition_attach(rmw_zp_guard_condition_t* guard_condition,
+                                        rmw_zp_wait_set_attachment_t* attachment);
 
-bool rmw_zp_guard_condition_detach_condition_and_is_trigger_set(
-    rmw_zp_guard_condition_t* guard_condition);
+// Return whether the guard condition was triggered, and reset it.
+bool rmw_zp_guard_condition_take_trigger(rmw_zp_guard_condition_t* guard_condition);
 
 #endif
\ No newline at end of file
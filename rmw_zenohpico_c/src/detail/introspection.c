@@ -0,0 +1,262 @@
+#include "./introspection.h"
+
+#include <string.h>
+
+#include "rcutils/allocator.h"
+#include "rosidl_runtime_c/message_initialization.h"
+#include "rosidl_runtime_c/string.h"
+#include "rosidl_typesupport_introspection_c/field_types.h"
+
+// Layout shared by all the sequence types of rosidl_runtime_c. Their memory is managed with the
+// default allocator, which is used here as well to grow them.
+typedef struct {
+  void *data;
+  size_t size;
+  size_t capacity;
+} sequence_t;
+
+static const rosidl_typesupport_introspection_c__MessageMembers *get_nested_members(
+    const rosidl_typesupport_introspection_c__MessageMember *member) {
+  return member->members_->data;
+}
+
+// Size of a primitive type, 0 for strings and nested messages.
+static size_t get_primitive_size(uint8_t type_id) {
+  switch (type_id) {
+    case rosidl_typesupport_introspection_c__ROS_TYPE_CHAR:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_BOOLEAN:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_OCTET:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT8:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT8:
+      return 1;
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT16:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT16:
+      return 2;
+    case rosidl_typesupport_introspection_c__ROS_TYPE_FLOAT:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT32:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT32:
+      return 4;
+    case rosidl_typesupport_introspection_c__ROS_TYPE_DOUBLE:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT64:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT64:
+      return 8;
+    default:
+      return 0;
+  }
+}
+
+bool rmw_zp_introspection_can_deserialize(
+    const rosidl_typesupport_introspection_c__MessageMembers *members) {
+  for (uint32_t i = 0; i < members->member_count_; i++) {
+    const rosidl_typesupport_introspection_c__MessageMember *member = &members->members_[i];
+    switch (member->type_id_) {
+      case rosidl_typesupport_introspection_c__ROS_TYPE_STRING:
+        break;
+      case rosidl_typesupport_introspection_c__ROS_TYPE_MESSAGE:
+        if (!rmw_zp_introspection_can_deserialize(get_nested_members(member))) {
+          return false;
+        }
+        break;
+      default:
+        if (get_primitive_size(member->type_id_) == 0) {
+          return false;
+        }
+        break;
+    }
+  }
+
+  return true;
+}
+
+static bool deserialize_primitives(ucdrBuffer *ub, uint8_t type_id, void *data, size_t count) {
+  // Keeps the alignment of empty arrays consistent with the serializer, without passing NULL.
+  uint64_t empty;
+  if (data == NULL) {
+    data = &empty;
+  }
+
+  switch (type_id) {
+    case rosidl_typesupport_introspection_c__ROS_TYPE_CHAR:
+      return ucdr_deserialize_array_char(ub, data, count);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_BOOLEAN:
+      return ucdr_deserialize_array_bool(ub, data, count);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_OCTET:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT8:
+      return ucdr_deserialize_array_uint8_t(ub, data, count);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT8:
+      return ucdr_deserialize_array_int8_t(ub, data, count);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT16:
+      return ucdr_deserialize_array_uint16_t(ub, data, count);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT16:
+      return ucdr_deserialize_array_int16_t(ub, data, count);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_FLOAT:
+      return ucdr_deserialize_array_float(ub, data, count);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT32:
+      return ucdr_deserialize_array_uint32_t(ub, data, count);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT32:
+      return ucdr_deserialize_array_int32_t(ub, data, count);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_DOUBLE:
+      return ucdr_deserialize_array_double(ub, data, count);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT64:
+      return ucdr_deserialize_array_uint64_t(ub, data, count);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT64:
+      return ucdr_deserialize_array_int64_t(ub, data, count);
+    default:
+      return false;
+  }
+}
+
+static bool deserialize_string(ucdrBuffer *ub, rosidl_runtime_c__String *string) {
+  // The length includes the null terminator.
+  uint32_t length;
+  if (!ucdr_deserialize_uint32_t(ub, &length) || length == 0 ||
+      length > ucdr_buffer_remaining(ub)) {
+    return false;
+  }
+
+  if (string->capacity < length) {
+    rcutils_allocator_t allocator = rcutils_get_default_allocator();
+    char *data = allocator.reallocate(string->data, length, allocator.state);
+    if (data == NULL) {
+      return false;
+    }
+    string->data = data;
+    string->capacity = length;
+  }
+
+  if (!ucdr_deserialize_array_char(ub, string->data, length)) {
+    return false;
+  }
+
+  string->data[length - 1] = '\0';
+  string->size = strlen(string->data);
+
+  return true;
+}
+
+// Deserialize `count` consecutive strings or nested messages, or primitives of the given type.
+static bool deserialize_elements(ucdrBuffer *ub,
+                                 const rosidl_typesupport_introspection_c__MessageMember *member,
+                                 void *data, size_t count) {
+  switch (member->type_id_) {
+    case rosidl_typesupport_introspection_c__ROS_TYPE_STRING: {
+      rosidl_runtime_c__String *strings = data;
+      for (size_t i = 0; i < count; i++) {
+        if (!deserialize_string(ub, &strings[i])) {
+          return false;
+        }
+      }
+      return true;
+    }
+    case rosidl_typesupport_introspection_c__ROS_TYPE_MESSAGE: {
+      const rosidl_typesupport_introspection_c__MessageMembers *nested = get_nested_members(member);
+      uint8_t *messages = data;
+      for (size_t i = 0; i < count; i++) {
+        if (!rmw_zp_introspection_deserialize(nested, ub, &messages[i * nested->size_of_])) {
+          return false;
+        }
+      }
+      return true;
+    }
+    default:
+      return deserialize_primitives(ub, member->type_id_, data, count);
+  }
+}
+
+// Make room for `count` elements, initializing the ones that are new. Elements beyond the size of
+// the sequence stay initialized, as sequences are finalized up to their capacity.
+static bool reserve_sequence(const rosidl_typesupport_introspection_c__MessageMember *member,
+                             sequence_t *sequence, size_t count) {
+  if (count <= sequence->capacity) {
+    return true;
+  }
+
+  size_t element_size;
+  if (member->type_id_ == rosidl_typesupport_introspection_c__ROS_TYPE_STRING) {
+    element_size = sizeof(rosidl_runtime_c__String);
+  } else if (member->type_id_ == rosidl_typesupport_introspection_c__ROS_TYPE_MESSAGE) {
+    element_size = get_nested_members(member)->size_of_;
+  } else {
+    element_size = get_primitive_size(member->type_id_);
+  }
+
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  uint8_t *data = allocator.reallocate(sequence->data, count * element_size, allocator.state);
+  if (data == NULL) {
+    return false;
+  }
+  sequence->data = data;
+
+  for (size_t i = sequence->capacity; i < count; i++) {
+    void *element = &data[i * element_size];
+    if (member->type_id_ == rosidl_typesupport_introspection_c__ROS_TYPE_STRING) {
+      if (!rosidl_runtime_c__String__init(element)) {
+        // The elements initialized so far are kept, so that they get finalized.
+        sequence->capacity = i;
+        return false;
+      }
+    } else if (member->type_id_ == rosidl_typesupport_introspection_c__ROS_TYPE_MESSAGE) {
+      if (!get_nested_members(member)->init_function(element, ROSIDL_RUNTIME_C_MSG_INIT_ALL)) {
+        sequence->capacity = i;
+        return false;
+      }
+    }
+  }
+  sequence->capacity = count;
+
+  return true;
+}
+
+static bool deserialize_sequence(ucdrBuffer *ub,
+                                 const rosidl_typesupport_introspection_c__MessageMember *member,
+                                 sequence_t *sequence) {
+  uint32_t count;
+  if (!ucdr_deserialize_uint32_t(ub, &count)) {
+    return false;
+  }
+
+  if (member->is_upper_bound_ && count > member->array_size_) {
+    return false;
+  }
+
+  // Every element takes at least one byte, or the size of a primitive. Checked before growing the
+  // sequence, so that a corrupted length cannot make it allocate arbitrary amounts of memory.
+  const size_t primitive_size = get_primitive_size(member->type_id_);
+  if (count > ucdr_buffer_remaining(ub) / (primitive_size > 0 ? primitive_size : 1)) {
+    return false;
+  }
+
+  if (!reserve_sequence(member, sequence, count)) {
+    return false;
+  }
+
+  sequence->size = count;
+
+  return deserialize_elements(ub, member, sequence->data, count);
+}
+
+bool rmw_zp_introspection_deserialize(
+    const rosidl_typesupport_introspection_c__MessageMembers *members, ucdrBuffer *ub,
+    void *ros_message) {
+  uint8_t *message = ros_message;
+
+  for (uint32_t i = 0; i < members->member_count_; i++) {
+    const rosidl_typesupport_introspection_c__MessageMember *member = &members->members_[i];
+    void *field = &message[member->offset_];
+
+    bool ok;
+    if (!member->is_array_) {
+      ok = deserialize_elements(ub, member, field, 1);
+    } else if (member->array_size_ > 0 && !member->is_upper_bound_) {
+      ok = deserialize_elements(ub, member, field, member->array_size_);
+    } else {
+      ok = deserialize_sequence(ub, member, field);
+    }
+
+    if (!ok) {
+      return false;
+    }
+  }
+
+  return !ub->error;
+}
\ No newline at end of file
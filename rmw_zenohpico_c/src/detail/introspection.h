@@ -0,0 +1,25 @@
+#ifndef RMW_ZENOHPICO_DETAIL__INTROSPECTION_H_
+#define RMW_ZENOHPICO_DETAIL__INTROSPECTION_H_
+
+#include <stdbool.h>
+
+#include "rosidl_typesupport_introspection_c/message_introspection.h"
+#include "ucdr/microcdr.h"
+
+// CDR deserialization driven by the introspection type support, as an alternative to the
+// microxrcedds type support for messages that are reused between takes. The microxrcedds type
+// support only deserializes into the capacity the sequences and strings of a message already have,
+// while this grows them as needed. Their memory is kept, so a message taken repeatedly stops
+// allocating once it has seen the largest sample.
+
+// Whether messages of this type can be deserialized, i.e. they have no wide string, wide character
+// or long double member, which the microxrcedds type support does not serialize either.
+bool rmw_zp_introspection_can_deserialize(
+    const rosidl_typesupport_introspection_c__MessageMembers *members);
+
+// Deserialize into an initialized message, growing its sequences and strings as needed.
+bool rmw_zp_introspection_deserialize(
+    const rosidl_typesupport_introspection_c__MessageMembers *members, ucdrBuffer *ub,
+    void *ros_message);
+
+#endif
\ No newline at end of file
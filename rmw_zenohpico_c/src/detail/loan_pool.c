@@ -0,0 +1,156 @@
+#include "./loan_pool.h"
+
+#include "rmw/error_handling.h"
+#include "rosidl_runtime_c/message_initialization.h"
+
+rmw_ret_t rmw_zp_loan_pool_init(rmw_zp_loan_pool_t *loan_pool,
+                                const rosidl_typesupport_introspection_c__MessageMembers *members,
+                                size_t capacity, rcutils_allocator_t *allocator) {
+  if (z_mutex_init(&loan_pool->mutex) < 0) {
+    RMW_SET_ERROR_MSG("Failed to initialize zenohpico mutex");
+    return RMW_RET_ERROR;
+  }
+
+  loan_pool->members = members;
+  loan_pool->allocator = *allocator;
+  loan_pool->capacity = capacity;
+  loan_pool->messages = NULL;
+  loan_pool->is_on_loan = NULL;
+  loan_pool->free_indices = NULL;
+  loan_pool->free_count = 0;
+
+  return RMW_RET_OK;
+}
+
+// Allocate and initialize the messages. Called with the mutex held.
+static rmw_ret_t allocate_messages(rmw_zp_loan_pool_t *loan_pool) {
+  const rosidl_typesupport_introspection_c__MessageMembers *members = loan_pool->members;
+  const size_t capacity = loan_pool->capacity;
+  rcutils_allocator_t *allocator = &loan_pool->allocator;
+
+  loan_pool->messages = allocator->zero_allocate(capacity, members->size_of_, allocator->state);
+  if (loan_pool->messages == NULL) {
+    RMW_SET_ERROR_MSG("Failed to allocate loaned messages");
+    return RMW_RET_BAD_ALLOC;
+  }
+
+  loan_pool->is_on_loan = allocator->zero_allocate(capacity, sizeof(bool), allocator->state);
+  if (loan_pool->is_on_loan == NULL) {
+    RMW_SET_ERROR_MSG("Failed to allocate loaned messages flags");
+    goto fail_allocate_is_on_loan;
+  }
+
+  loan_pool->free_indices = allocator->allocate(capacity * sizeof(size_t), allocator->state);
+  if (loan_pool->free_indices == NULL) {
+    RMW_SET_ERROR_MSG("Failed to allocate loaned messages indices");
+    goto fail_allocate_free_indices;
+  }
+
+  // Pushed in reverse, so that the first message is lent first.
+  for (size_t i = 0; i < capacity; i++) {
+    members->init_function(&loan_pool->messages[i * members->size_of_],
+                           ROSIDL_RUNTIME_C_MSG_INIT_ALL);
+    loan_pool->free_indices[i] = capacity - 1 - i;
+  }
+  loan_pool->free_count = capacity;
+
+  return RMW_RET_OK;
+
+fail_allocate_free_indices:
+  allocator->deallocate(loan_pool->is_on_loan, allocator->state);
+  loan_pool->is_on_loan = NULL;
+fail_allocate_is_on_loan:
+  allocator->deallocate(loan_pool->messages, allocator->state);
+  loan_pool->messages = NULL;
+  return RMW_RET_BAD_ALLOC;
+}
+
+rmw_ret_t rmw_zp_loan_pool_fini(rmw_zp_loan_pool_t *loan_pool) {
+  if (!rmw_zp_loan_pool_is_initialized(loan_pool)) {
+    return RMW_RET_OK;
+  }
+
+  rmw_ret_t ret = RMW_RET_OK;
+  rcutils_allocator_t *allocator = &loan_pool->allocator;
+
+  if (loan_pool->messages != NULL) {
+    if (loan_pool->free_count != loan_pool->capacity) {
+      RMW_SET_ERROR_MSG("Finalizing loan pool with messages still on loan");
+      ret = RMW_RET_ERROR;
+    }
+
+    for (size_t i = 0; i < loan_pool->capacity; i++) {
+      loan_pool->members->fini_function(&loan_pool->messages[i * loan_pool->members->size_of_]);
+    }
+
+    allocator->deallocate(loan_pool->free_indices, allocator->state);
+    allocator->deallocate(loan_pool->is_on_loan, allocator->state);
+    allocator->deallocate(loan_pool->messages, allocator->state);
+    loan_pool->messages = NULL;
+  }
+
+  if (z_drop(z_move(loan_pool->mutex)) < 0) {
+    RMW_SET_ERROR_MSG("Failed to drop zenohpico mutex");
+    ret = RMW_RET_ERROR;
+  }
+
+  loan_pool->members = NULL;
+
+  return ret;
+}
+
+bool rmw_zp_loan_pool_is_initialized(const rmw_zp_loan_pool_t *loan_pool) {
+  return loan_pool->members != NULL;
+}
+
+void *rmw_zp_loan_pool_borrow(rmw_zp_loan_pool_t *loan_pool) {
+  z_mutex_lock(z_loan_mut(loan_pool->mutex));
+
+  if (loan_pool->messages == NULL && allocate_messages(loan_pool) != RMW_RET_OK) {
+    z_mutex_unlock(z_loan_mut(loan_pool->mutex));
+    return NULL;
+  }
+
+  if (loan_pool->free_count == 0) {
+    z_mutex_unlock(z_loan_mut(loan_pool->mutex));
+    RMW_SET_ERROR_MSG("All loaned messages are in use");
+    return NULL;
+  }
+
+  size_t index = loan_pool->free_indices[--loan_pool->free_count];
+  loan_pool->is_on_loan[index] = true;
+
+  z_mutex_unlock(z_loan_mut(loan_pool->mutex));
+
+  return &loan_pool->messages[index * loan_pool->members->size_of_];
+}
+
+rmw_ret_t rmw_zp_loan_pool_return(rmw_zp_loan_pool_t *loan_pool, void *message) {
+  const size_t message_size = loan_pool->members->size_of_;
+  const uint8_t *message_bytes = message;
+
+  z_mutex_lock(z_loan_mut(loan_pool->mutex));
+
+  if (loan_pool->messages == NULL || message_bytes < loan_pool->messages ||
+      message_bytes >= loan_pool->messages + loan_pool->capacity * message_size ||
+      (size_t)(message_bytes - loan_pool->messages) % message_size != 0) {
+    z_mutex_unlock(z_loan_mut(loan_pool->mutex));
+    RMW_SET_ERROR_MSG("Message was not loaned from this entity");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+
+  size_t index = (size_t)(message_bytes - loan_pool->messages) / message_size;
+
+  if (!loan_pool->is_on_loan[index]) {
+    z_mutex_unlock(z_loan_mut(loan_pool->mutex));
+    RMW_SET_ERROR_MSG("Returning a message that is not on loan");
+    return RMW_RET_ERROR;
+  }
+
+  loan_pool->is_on_loan[index] = false;
+  loan_pool->free_indices[loan_pool->free_count++] = index;
+
+  z_mutex_unlock(z_loan_mut(loan_pool->mutex));
+
+  return RMW_RET_OK;
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#ifndef RMW_ZENOHPICO_DETAIL__LOAN_POOL_H_
+#define RMW_ZENOHPICO_DETAIL__LOAN_POOL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "rcutils/allocator.h"
+#include "rmw/ret_types.h"
+#include "rosidl_typesupport_introspection_c/message_introspection.h"
+#include "zenoh-pico.h"
+
+// A fixed set of ROS messages that are lent to the application. The messages are only allocated
+// and initialized on the first loan, so entities that never loan do not pay for them. Returned
+// messages are recycled as they are, so the sequences they own keep their memory for the next loan.
+typedef struct {
+  const rosidl_typesupport_introspection_c__MessageMembers *members;
+  rcutils_allocator_t allocator;
+  size_t capacity;
+
+  // The fields below are guarded by mutex.
+  z_owned_mutex_t mutex;
+
+  // Storage for `capacity` messages of `members->size_of_` bytes each. NULL until the first loan.
+  uint8_t *messages;
+
+  // Whether each message is currently lent out, so that a message returned twice is rejected.
+  bool *is_on_loan;
+
+  // Stack of the indices of the messages that are not currently lent out.
+  size_t *free_indices;
+  size_t free_count;
+} rmw_zp_loan_pool_t;
+
+// Does not allocate any message yet.
+rmw_ret_t rmw_zp_loan_pool_init(rmw_zp_loan_pool_t *loan_pool,
+                                const rosidl_typesupport_introspection_c__MessageMembers *members,
+                                size_t capacity, rcutils_allocator_t *allocator);
+
+// Safe to call on a zero-initialized pool that was never initialized.
+rmw_ret_t rmw_zp_loan_pool_fini(rmw_zp_loan_pool_t *loan_pool);
+
+bool rmw_zp_loan_pool_is_initialized(const rmw_zp_loan_pool_t *loan_pool);
+
+// Returns NULL, with the error message set, if all the messages are currently lent out or they
+// could not be allocated.
+void *rmw_zp_loan_pool_borrow(rmw_zp_loan_pool_t *loan_pool);
+
+rmw_ret_t rmw_zp_loan_pool_return(rmw_zp_loan_pool_t *loan_pool, void *message);
+
+#endif
\ No newline at end of file
@@ -3,95 +3,357 @@
 #include "./time.h"
 #include "rmw/error_handling.h"
 
+rmw_ret_t rmw_zp_message_init(rmw_zp_message_t *message, const z_loaned_bytes_t *attachment,
+                              const z_loaned_bytes_t *payload) {
+  if (rmw_zp_get_current_timestamp(&message->received_timestamp) != RMW_RET_OK) {
+    return RMW_RET_ERROR;
+  }
+
+  if (rmw_zp_attachment_data_deserialize_from_zbytes(attachment, &message->attachment_data) !=
+      RMW_RET_OK) {
+    return RMW_RET_ERROR;
+  }
+
+  // Publishers send the CDR buffer as is. Cloning only takes a reference to the received
+  // buffers, so nothing is copied on the read task.
+  if (z_bytes_clone(&message->payload, payload) < 0) {
+    RMW_SET_ERROR_MSG("Failed to clone payload");
+    return RMW_RET_ERROR;
+  }
+
+  return RMW_RET_OK;
+}
+
+void rmw_zp_message_fini(rmw_zp_message_t *message) { z_drop(z_move(message->payload)); }
+
+rmw_ret_t rmw_zp_message_get_payload_view(const rmw_zp_message_t *message,
+                                          rcutils_allocator_t *allocator,
+                                          rmw_zp_payload_view_t *view) {
+  const z_loaned_bytes_t *payload = z_loan(message->payload);
+
+  view->data = NULL;
+  view->len = z_bytes_len(payload);
+  view->linearized = NULL;
+
+  z_bytes_slice_iterator_t slice_iterator = z_bytes_get_slice_iterator(payload);
+  z_view_slice_t first_slice;
+  if (!z_bytes_slice_iterator_next(&slice_iterator, &first_slice)) {
+    return RMW_RET_OK;
+  }
+
+  if (z_slice_len(z_loan(first_slice)) == view->len) {
+    view->data = z_slice_data(z_loan(first_slice));
+    return RMW_RET_OK;
+  }
+
+  view->linearized = allocator->allocate(view->len, allocator->state);
+  if (view->linearized == NULL) {
+    RMW_SET_ERROR_MSG("Failed to allocate buffer for fragmented payload");
+    return RMW_RET_BAD_ALLOC;
+  }
+
+  z_bytes_reader_t reader = z_bytes_get_reader(payload);
+  if (z_bytes_reader_read(&reader, view->linearized, view->len) != view->len) {
+    RMW_SET_ERROR_MSG("Failed to read fragmented payload");
+    allocator->deallocate(view->linearized, allocator->state);
+    view->linearized = NULL;
+    return RMW_RET_ERROR;
+  }
+
+  view->data = view->linearized;
+  return RMW_RET_OK;
+}
+
+void rmw_zp_payload_view_fini(rmw_zp_payload_view_t *view, rcutils_allocator_t *allocator) {
+  if (view->linearized != NULL) {
+    allocator->deallocate(view->linearized, allocator->state);
+    view->linearized = NULL;
+  }
+}
+
 rmw_ret_t rmw_zp_message_queue_init(rmw_zp_message_queue_t *message_queue, size_t capacity,
                                     rcutils_allocator_t *allocator) {
+  size_t slot_count = 1;
+  while (slot_count < capacity) {
+    slot_count <<= 1;
+  }
+
   message_queue->capacity = capacity;
-  message_queue->size = message_queue->idx_front = message_queue->idx_back = 0;
+  message_queue->slot_mask = slot_count - 1;
 
   message_queue->messages =
-      allocator->allocate(capacity * sizeof(rmw_zp_message_t), allocator->state);
+      allocator->allocate(slot_count * sizeof(rmw_zp_message_t), allocator->state);
 
   if (message_queue->messages == NULL) {
     RMW_SET_ERROR_MSG("Failed to allocate message queue");
     return RMW_RET_ERROR;
   }
 
+#if RMW_ZP_HAVE_ATOMICS
+  message_queue->slots =
+      allocator->allocate(slot_count * sizeof(rmw_zp_message_slot_t), allocator->state);
+
+  if (message_queue->slots == NULL) {
+    RMW_SET_ERROR_MSG("Failed to allocate message queue");
+    allocator->deallocate(message_queue->messages, allocator->state);
+    message_queue->messages = NULL;
+    return RMW_RET_ERROR;
+  }
+
+  for (size_t i = 0; i < slot_count; i++) {
+    atomic_init(&message_queue->slots[i].sequence, i);
+    atomic_init(&message_queue->slots[i].source_timestamp, 0);
+  }
+  atomic_init(&message_queue->head, 0);
+  atomic_init(&message_queue->tail, 0);
+#else
+  message_queue->head = message_queue->tail = 0;
+
+  if (z_mutex_init(&message_queue->mutex) < 0) {
+    RMW_SET_ERROR_MSG("Failed to initialize zenohpico mutex");
+    allocator->deallocate(message_queue->messages, allocator->state);
+    message_queue->messages = NULL;
+    return RMW_RET_ERROR;
+  }
+#endif
+
   return RMW_RET_OK;
 }
 
 rmw_ret_t rmw_zp_message_queue_fini(rmw_zp_message_queue_t *message_queue,
                                     rcutils_allocator_t *allocator) {
+  rmw_ret_t ret = RMW_RET_OK;
+
   if (message_queue->messages != NULL) {
+    while (rmw_zp_message_queue_pop_front(message_queue, NULL)) {
+    }
     allocator->deallocate(message_queue->messages, allocator->state);
+    message_queue->messages = NULL;
+#if RMW_ZP_HAVE_ATOMICS
+    allocator->deallocate(message_queue->slots, allocator->state);
+#endif
   }
 
-  return RMW_RET_OK;
+#if !RMW_ZP_HAVE_ATOMICS
+  if (z_drop(z_move(message_queue->mutex)) < 0) {
+    RMW_SET_ERROR_MSG("Failed to drop zenohpico mutex");
+    ret = RMW_RET_ERROR;
+  }
+#endif
+
+  return ret;
 }
 
-rmw_ret_t rmw_zp_message_queue_pop_front(rmw_zp_message_queue_t *message_queue,
-                                         rmw_zp_message_t *msg_data) {
-  if (message_queue->size == 0) {
-    RMW_SET_ERROR_MSG("Trying to pop messages from empty queue");
-    return RMW_RET_ERROR;
+#if RMW_ZP_HAVE_ATOMICS
+
+// Move the messages from `head` to `head + count`, which the caller claimed by advancing head past
+// them, out of their slots and hand the slots back to the producer. If `messages` is NULL, the
+// messages are finalized instead.
+static void move_out_claimed(rmw_zp_message_queue_t *message_queue, size_t head, size_t count,
+                             rmw_zp_message_t *messages) {
+  for (size_t i = 0; i < count; i++) {
+    const size_t slot_index = (head + i) & message_queue->slot_mask;
+    if (messages == NULL) {
+      rmw_zp_message_fini(&message_queue->messages[slot_index]);
+    } else {
+      messages[i] = message_queue->messages[slot_index];
+    }
+    atomic_store_explicit(&message_queue->slots[slot_index].sequence,
+                          head + i + message_queue->slot_mask + 1, memory_order_release);
   }
+}
 
-  rmw_zp_message_t *front_message = &message_queue->messages[message_queue->idx_front];
+bool rmw_zp_message_queue_push_back(rmw_zp_message_queue_t *message_queue,
+                                    rmw_zp_message_t *message, rmw_zp_message_t *dropped_message) {
+  // Only the producer moves the tail.
+  const size_t tail = atomic_load_explicit(&message_queue->tail, memory_order_relaxed);
+  size_t head = atomic_load_explicit(&message_queue->head, memory_order_acquire);
+  bool dropped = false;
 
-  z_moved_slice_t *payload_moved = z_move(front_message->payload);
-  if (msg_data == NULL) {
-    z_drop(payload_moved);
-  } else {
-    // TODO(bjsowa): move instead of clone
-    rmw_zp_attachment_data_clone(&front_message->attachment_data, &msg_data->attachment_data);
-    z_take(&msg_data->payload, payload_moved);
+  while (tail - head >= message_queue->capacity) {
+    // On failure head is reloaded, and a consumer may have made room in the meantime.
+    if (atomic_compare_exchange_weak_explicit(&message_queue->head, &head, head + 1,
+                                              memory_order_acq_rel, memory_order_acquire)) {
+      move_out_claimed(message_queue, head, 1, dropped_message);
+      dropped = true;
+      break;
+    }
   }
 
-  message_queue->size--;
-  message_queue->idx_front++;
-  if (message_queue->idx_front == message_queue->capacity) {
-    message_queue->idx_front = 0;
+  // The consumer of the message that used the slot before may not be done moving it out yet. That
+  // only takes a struct copy, unless the consumer is preempted in the middle of it.
+  rmw_zp_message_slot_t *slot = &message_queue->slots[tail & message_queue->slot_mask];
+  while (atomic_load_explicit(&slot->sequence, memory_order_acquire) != tail) {
+    z_sleep_us(1);
   }
 
-  return RMW_RET_OK;
+  message_queue->messages[tail & message_queue->slot_mask] = *message;
+  atomic_store_explicit(&slot->source_timestamp, message->attachment_data.source_timestamp,
+                        memory_order_relaxed);
+  atomic_store_explicit(&slot->sequence, tail + 1, memory_order_release);
+  atomic_store_explicit(&message_queue->tail, tail + 1, memory_order_release);
+
+  return dropped;
 }
 
-rmw_ret_t rmw_zp_message_queue_push_back(rmw_zp_message_queue_t *message_queue,
-                                         const z_loaned_bytes_t *attachment,
-                                         const z_loaned_bytes_t *payload,
-                                         const rmw_zp_message_t **message) {
-  if (message_queue->size == message_queue->capacity) {
-    RMW_SET_ERROR_MSG("Trying to push messages to a queue that is full");
-    return RMW_RET_ERROR;
+bool rmw_zp_message_queue_pop_front(rmw_zp_message_queue_t *message_queue,
+                                    rmw_zp_message_t *message) {
+  return rmw_zp_message_queue_pop_front_n(message_queue, message, 1) == 1;
+}
+
+size_t rmw_zp_message_queue_pop_front_n(rmw_zp_message_queue_t *message_queue,
+                                        rmw_zp_message_t *messages, size_t count) {
+  size_t head = atomic_load_explicit(&message_queue->head, memory_order_acquire);
+
+  for (;;) {
+    const size_t tail = atomic_load_explicit(&message_queue->tail, memory_order_acquire);
+    const size_t available = tail - head;
+    const size_t n = available < count ? available : count;
+    if (n == 0) {
+      return 0;
+    }
+
+    // Nothing is read from the slots before they are claimed. Once they are, the producer leaves
+    // them alone until their sequence is updated.
+    if (atomic_compare_exchange_weak_explicit(&message_queue->head, &head, head + n,
+                                              memory_order_acq_rel, memory_order_acquire)) {
+      move_out_claimed(message_queue, head, n, messages);
+      return n;
+    }
   }
+}
 
-  rmw_zp_message_t *back_message = &message_queue->messages[message_queue->idx_front];
+size_t rmw_zp_message_queue_drop_expired(rmw_zp_message_queue_t *message_queue,
+                                         int64_t min_source_timestamp) {
+  size_t dropped = 0;
+  size_t head = atomic_load_explicit(&message_queue->head, memory_order_acquire);
 
-  if (rmw_zp_get_current_timestamp(&back_message->received_timestamp) != RMW_RET_OK) {
-    return RMW_RET_ERROR;
+  for (;;) {
+    const size_t tail = atomic_load_explicit(&message_queue->tail, memory_order_acquire);
+    if (head == tail) {
+      return dropped;
+    }
+
+    // If the front message was claimed in the meantime, the timestamp may belong to a later one.
+    // Then either it is not expired and the rest is left for the next call, or head moved and the
+    // compare-and-swap below fails.
+    rmw_zp_message_slot_t *slot = &message_queue->slots[head & message_queue->slot_mask];
+    if (atomic_load_explicit(&slot->source_timestamp, memory_order_relaxed) >=
+        min_source_timestamp) {
+      return dropped;
+    }
+
+    if (atomic_compare_exchange_weak_explicit(&message_queue->head, &head, head + 1,
+                                              memory_order_acq_rel, memory_order_acquire)) {
+      move_out_claimed(message_queue, head, 1, NULL);
+      dropped++;
+      head++;
+    }
   }
+}
 
-  if (rmw_zp_attachment_data_deserialize_from_zbytes(attachment, &back_message->attachment_data) !=
-      RMW_RET_OK) {
-    return RMW_RET_ERROR;
+size_t rmw_zp_message_queue_size(rmw_zp_message_queue_t *message_queue) {
+  const size_t head = atomic_load_explicit(&message_queue->head, memory_order_acquire);
+  const size_t tail = atomic_load_explicit(&message_queue->tail, memory_order_acquire);
+  // head may have been loaded before a concurrent pop that the tail load already accounts for.
+  return tail > head ? tail - head : 0;
+}
+
+#else
+
+bool rmw_zp_message_queue_push_back(rmw_zp_message_queue_t *message_queue,
+                                    rmw_zp_message_t *message, rmw_zp_message_t *dropped_message) {
+  z_mutex_lock(z_loan_mut(message_queue->mutex));
+
+  bool dropped = false;
+  if (message_queue->tail - message_queue->head >= message_queue->capacity) {
+    rmw_zp_message_t *oldest_message =
+        &message_queue->messages[message_queue->head & message_queue->slot_mask];
+    if (dropped_message == NULL) {
+      rmw_zp_message_fini(oldest_message);
+    } else {
+      *dropped_message = *oldest_message;
+    }
+    message_queue->head++;
+    dropped = true;
   }
 
-  // TODO(bjsowa): avoid dynamic allocation
-  ze_deserializer_t deserializer = ze_deserializer_from_bytes(payload);
+  message_queue->messages[message_queue->tail & message_queue->slot_mask] = *message;
+  message_queue->tail++;
 
-  if (ze_deserializer_deserialize_slice(&deserializer, &back_message->payload) < 0) {
-    RMW_SET_ERROR_MSG("Failed to deserialize payload into slice");
-    return RMW_RET_ERROR;
+  z_mutex_unlock(z_loan_mut(message_queue->mutex));
+
+  return dropped;
+}
+
+bool rmw_zp_message_queue_pop_front(rmw_zp_message_queue_t *message_queue,
+                                    rmw_zp_message_t *message) {
+  z_mutex_lock(z_loan_mut(message_queue->mutex));
+
+  if (message_queue->head == message_queue->tail) {
+    z_mutex_unlock(z_loan_mut(message_queue->mutex));
+    return false;
   }
 
-  message_queue->size++;
-  message_queue->idx_back++;
-  if (message_queue->idx_back == message_queue->capacity) {
-    message_queue->idx_back = 0;
+  rmw_zp_message_t *front_message =
+      &message_queue->messages[message_queue->head & message_queue->slot_mask];
+  if (message == NULL) {
+    rmw_zp_message_fini(front_message);
+  } else {
+    *message = *front_message;
   }
+  message_queue->head++;
 
-  if (message != NULL) {
-    *message = back_message;
+  z_mutex_unlock(z_loan_mut(message_queue->mutex));
+
+  return true;
+}
+
+size_t rmw_zp_message_queue_pop_front_n(rmw_zp_message_queue_t *message_queue,
+                                        rmw_zp_message_t *messages, size_t count) {
+  z_mutex_lock(z_loan_mut(message_queue->mutex));
+
+  size_t n = 0;
+  while (n < count && message_queue->head != message_queue->tail) {
+    messages[n++] = message_queue->messages[message_queue->head & message_queue->slot_mask];
+    message_queue->head++;
   }
 
-  return RMW_RET_OK;
+  z_mutex_unlock(z_loan_mut(message_queue->mutex));
+
+  return n;
+}
+
+size_t rmw_zp_message_queue_drop_expired(rmw_zp_message_queue_t *message_queue,
+                                         int64_t min_source_timestamp) {
+  z_mutex_lock(z_loan_mut(message_queue->mutex));
+
+  size_t dropped = 0;
+  while (message_queue->head != message_queue->tail) {
+    rmw_zp_message_t *front_message =
+        &message_queue->messages[message_queue->head & message_queue->slot_mask];
+    if (front_message->attachment_data.source_timestamp >= min_source_timestamp) {
+      break;
+    }
+    rmw_zp_message_fini(front_message);
+    message_queue->head++;
+    dropped++;
+  }
+
+  z_mutex_unlock(z_loan_mut(message_queue->mutex));
+
+  return dropped;
+}
+
+size_t rmw_zp_message_queue_size(rmw_zp_message_queue_t *message_queue) {
+  z_mutex_lock(z_loan_mut(message_queue->mutex));
+  size_t size = message_queue->tail - message_queue->head;
+  z_mutex_unlock(z_loan_mut(message_queue->mutex));
+  return size;
+}
+
+#endif
+
+bool rmw_zp_message_queue_is_empty(rmw_zp_message_queue_t *message_queue) {
+  return rmw_zp_message_queue_size(message_queue) == 0;
 }
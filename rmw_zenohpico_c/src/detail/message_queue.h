@@ -1,6 +1,9 @@
 #ifndef RMW_ZENOHPICO_DETAIL__MESSAGE_QUEUE_H_
 #define RMW_ZENOHPICO_DETAIL__MESSAGE_QUEUE_H_
 
+#include <stdbool.h>
+
+#include "./atomic.h"
 #include "./attachment_helpers.h"
 #include "rcutils/allocator.h"
 #include "rmw/ret_types.h"
@@ -9,29 +12,99 @@
 typedef struct {
   int64_t received_timestamp;
   rmw_zp_attachment_data_t attachment_data;
-  z_owned_slice_t payload;
+  // Reference-counted clone of the received payload, sharing its buffers instead of copying them.
+  z_owned_bytes_t payload;
 } rmw_zp_message_t;
 
+// Contiguous view of a message payload. The payload is only copied, into `linearized`, if it was
+// received in several fragments.
+typedef struct {
+  const uint8_t *data;
+  size_t len;
+  uint8_t *linearized;
+} rmw_zp_payload_view_t;
+
+#if RMW_ZP_HAVE_ATOMICS
+typedef struct {
+  // Turn of the slot: i while it is free for message i, i + 1 once message i is in it, and
+  // i + slot_count once message i was moved out of it.
+  atomic_size_t sequence;
+  // Source timestamp of the message in the slot, which can be read before claiming it.
+  atomic_int_fast64_t source_timestamp;
+} rmw_zp_message_slot_t;
+#endif
+
+// Bounded queue with KEEP_LAST semantics: pushing to a full queue drops the oldest message.
+//
+// With atomics available the queue is lock-free for a single producer (the zenoh-pico read task)
+// and any number of consumers. head and tail are monotonic counters of popped and pushed messages
+// and message i lives in slot (i & slot_mask). Consumers claim the front message by advancing head
+// with a compare-and-swap, and only then move it out of its slot. When the queue is full, the
+// producer claims the oldest message the same way. The sequence of a slot tells the producer when
+// the consumer of its previous message is done with it, so that a slot is never written while it
+// is being read. Without atomics the counters are guarded by a mutex.
 typedef struct {
   rmw_zp_message_t *messages;
+  // Maximum number of queued messages, i.e. the history depth.
   size_t capacity;
-  size_t size;
-  size_t idx_front;
-  size_t idx_back;
+  // Number of slots minus one. The number of slots is capacity rounded up to a power of two, so
+  // that slot indices stay consistent when the counters wrap around.
+  size_t slot_mask;
+#if RMW_ZP_HAVE_ATOMICS
+  rmw_zp_message_slot_t *slots;
+  atomic_size_t head;
+  atomic_size_t tail;
+#else
+  z_owned_mutex_t mutex;
+  size_t head;
+  size_t tail;
+#endif
 } rmw_zp_message_queue_t;
 
+// Fill a message from a received sample, stamped with the current time.
+rmw_ret_t rmw_zp_message_init(rmw_zp_message_t *message, const z_loaned_bytes_t *attachment,
+                              const z_loaned_bytes_t *payload);
+
+void rmw_zp_message_fini(rmw_zp_message_t *message);
+
+// The view must be released with rmw_zp_payload_view_fini before the message is finalized.
+rmw_ret_t rmw_zp_message_get_payload_view(const rmw_zp_message_t *message,
+                                          rcutils_allocator_t *allocator,
+                                          rmw_zp_payload_view_t *view);
+
+void rmw_zp_payload_view_fini(rmw_zp_payload_view_t *view, rcutils_allocator_t *allocator);
+
 rmw_ret_t rmw_zp_message_queue_init(rmw_zp_message_queue_t *message_queue, size_t capacity,
                                     rcutils_allocator_t *allocator);
 
+// Drops any messages left in the queue.
 rmw_ret_t rmw_zp_message_queue_fini(rmw_zp_message_queue_t *message_queue,
                                     rcutils_allocator_t *allocator);
 
-rmw_ret_t rmw_zp_message_queue_pop_front(rmw_zp_message_queue_t *message_queue,
-                                         rmw_zp_message_t *msg_data);
+// Move `message` into the queue. Must only be called from one thread at a time. Returns true if
+// the oldest message was dropped to make room for it, in which case it is moved into
+// `dropped_message`, or finalized if that is NULL.
+bool rmw_zp_message_queue_push_back(rmw_zp_message_queue_t *message_queue,
+                                    rmw_zp_message_t *message, rmw_zp_message_t *dropped_message);
+
+// Move the oldest message into `message`, or drop it if `message` is NULL. Returns false if the
+// queue was empty.
+bool rmw_zp_message_queue_pop_front(rmw_zp_message_queue_t *message_queue,
+                                    rmw_zp_message_t *message);
+
+// Move up to `count` of the oldest messages into `messages`, claiming all of them at once.
+// Returns the number of messages moved.
+size_t rmw_zp_message_queue_pop_front_n(rmw_zp_message_queue_t *message_queue,
+                                        rmw_zp_message_t *messages, size_t count);
+
+// Drop the messages at the front of the queue whose source timestamp is older than
+// `min_source_timestamp`, stopping at the first one that is not. Returns the number of messages
+// dropped.
+size_t rmw_zp_message_queue_drop_expired(rmw_zp_message_queue_t *message_queue,
+                                         int64_t min_source_timestamp);
+
+size_t rmw_zp_message_queue_size(rmw_zp_message_queue_t *message_queue);
 
-rmw_ret_t rmw_zp_message_queue_push_back(rmw_zp_message_queue_t *message_queue,
-                                         const z_loaned_bytes_t *attachment,
-                                         const z_loaned_bytes_t *payload,
-                                         const rmw_zp_message_t **message);
+bool rmw_zp_message_queue_is_empty(rmw_zp_message_queue_t *message_queue);
 
 #endif
\ No newline at end of file
@@ -4,34 +4,155 @@
 #include "rmw/error_handling.h"
 
 rmw_ret_t rmw_zp_publisher_init(rmw_zp_publisher_t* publisher,
-                                const rmw_qos_profile_t* qos_profile) {
-  publisher->sequence_number = 1;
+                                const rmw_qos_profile_t* qos_profile,
+                                size_t serialization_buffer_max_size,
+                                rmw_zp_timer_wheel_t* timer_wheel) {
   publisher->adapted_qos_profile = *qos_profile;
+  publisher->serialization_buffer = NULL;
+  publisher->serialization_buffer_capacity = 0;
+  publisher->serialization_buffer_max_size = serialization_buffer_max_size;
+  publisher->serialization_buffer_fallback_count = 0;
 
   if (rmw_zp_adapt_qos_profile(&publisher->adapted_qos_profile) != RMW_RET_OK) {
     return RMW_RET_ERROR;
   }
 
+#if RMW_ZP_HAVE_ATOMICS
+  atomic_init(&publisher->sequence_number, 1);
+#else
+  publisher->sequence_number = 1;
+
   if (z_mutex_init(&publisher->sequence_number_mutex) < 0) {
     RMW_SET_ERROR_MSG("Failed to initialize zenohpico mutex");
     return RMW_RET_ERROR;
   }
+#endif
+
+  if (z_mutex_init(&publisher->serialization_buffer_mutex) < 0) {
+    RMW_SET_ERROR_MSG("Failed to initialize zenohpico mutex");
+    goto fail_init_serialization_buffer_mutex;
+  }
+
+  if (rmw_zp_events_init(&publisher->events) != RMW_RET_OK) {
+    goto fail_init_events;
+  }
+
+  rmw_zp_deadline_init(&publisher->deadline, timer_wheel, publisher->adapted_qos_profile.deadline,
+                       &publisher->events, RMW_ZP_EVENT_OFFERED_DEADLINE_MISSED);
 
   return RMW_RET_OK;
+
+fail_init_events:
+  z_drop(z_move(publisher->serialization_buffer_mutex));
+fail_init_serialization_buffer_mutex:
+#if !RMW_ZP_HAVE_ATOMICS
+  z_drop(z_move(publisher->sequence_number_mutex));
+#endif
+  return RMW_RET_ERROR;
 }
 
-rmw_ret_t rmw_zp_publisher_fini(rmw_zp_publisher_t* publisher) {
+rmw_ret_t rmw_zp_publisher_fini(rmw_zp_publisher_t* publisher, rcutils_allocator_t* allocator) {
+  rmw_ret_t ret = RMW_RET_OK;
+
+  rmw_zp_deadline_fini(&publisher->deadline);
+
+  if (rmw_zp_events_fini(&publisher->events) != RMW_RET_OK) {
+    ret = RMW_RET_ERROR;
+  }
+
+  if (rmw_zp_loan_pool_fini(&publisher->loan_pool) != RMW_RET_OK) {
+    ret = RMW_RET_ERROR;
+  }
+
+  if (publisher->serialization_buffer != NULL) {
+    allocator->deallocate(publisher->serialization_buffer, allocator->state);
+    publisher->serialization_buffer = NULL;
+  }
+
+  if (z_drop(z_move(publisher->serialization_buffer_mutex)) < 0) {
+    RMW_SET_ERROR_MSG("Failed to drop zenohpico mutex");
+    ret = RMW_RET_ERROR;
+  }
+
+#if !RMW_ZP_HAVE_ATOMICS
   if (z_drop(z_move(publisher->sequence_number_mutex)) < 0) {
     RMW_SET_ERROR_MSG("Failed to drop zenohpico mutex");
-    return RMW_RET_ERROR;
+    ret = RMW_RET_ERROR;
   }
+#endif
 
-  return RMW_RET_OK;
+  return ret;
 }
 
 size_t rmw_zp_publisher_get_next_sequence_number(rmw_zp_publisher_t* publisher) {
+#if RMW_ZP_HAVE_ATOMICS
+  // Only uniqueness matters, the sequence number does not order any other memory access.
+  return atomic_fetch_add_explicit(&publisher->sequence_number, 1, memory_order_relaxed);
+#else
   z_mutex_lock(z_loan_mut(publisher->sequence_number_mutex));
   size_t seq = publisher->sequence_number++;
   z_mutex_unlock(z_loan_mut(publisher->sequence_number_mutex));
   return seq;
+#endif
+}
+
+static uint8_t* allocate_serialization_buffer(size_t size, rcutils_allocator_t* allocator) {
+  uint8_t* buffer = allocator->allocate(size, allocator->state);
+  if (buffer == NULL) {
+    RMW_SET_ERROR_MSG("Failed to allocate serialization buffer");
+  }
+  return buffer;
+}
+
+uint8_t* rmw_zp_publisher_acquire_serialization_buffer(rmw_zp_publisher_t* publisher, size_t size,
+                                                       rcutils_allocator_t* allocator,
+                                                       bool* is_shared) {
+  *is_shared = false;
+
+  // The shared buffer is held until the message is sent, so do not wait for another publication
+  // to be done with it.
+  if (z_mutex_try_lock(z_loan_mut(publisher->serialization_buffer_mutex)) != Z_OK) {
+    return allocate_serialization_buffer(size, allocator);
+  }
+
+  if (size > publisher->serialization_buffer_max_size) {
+    publisher->serialization_buffer_fallback_count++;
+    z_mutex_unlock(z_loan_mut(publisher->serialization_buffer_mutex));
+    return allocate_serialization_buffer(size, allocator);
+  }
+
+  if (size > publisher->serialization_buffer_capacity) {
+    // Grow geometrically so that messages of slowly increasing size do not reallocate every time.
+    size_t new_capacity = publisher->serialization_buffer_capacity * 2;
+    if (new_capacity < size) {
+      new_capacity = size;
+    }
+    if (new_capacity > publisher->serialization_buffer_max_size) {
+      new_capacity = publisher->serialization_buffer_max_size;
+    }
+
+    uint8_t* new_buffer =
+        allocator->reallocate(publisher->serialization_buffer, new_capacity, allocator->state);
+    if (new_buffer == NULL) {
+      RMW_SET_ERROR_MSG("Failed to grow serialization buffer");
+      z_mutex_unlock(z_loan_mut(publisher->serialization_buffer_mutex));
+      return NULL;
+    }
+
+    publisher->serialization_buffer = new_buffer;
+    publisher->serialization_buffer_capacity = new_capacity;
+  }
+
+  // The mutex stays locked until the buffer is released.
+  *is_shared = true;
+  return publisher->serialization_buffer;
+}
+
+void rmw_zp_publisher_release_serialization_buffer(rmw_zp_publisher_t* publisher, uint8_t* buffer,
+                                                   bool is_shared, rcutils_allocator_t* allocator) {
+  if (is_shared) {
+    z_mutex_unlock(z_loan_mut(publisher->serialization_buffer_mutex));
+  } else {
+    allocator->deallocate(buffer, allocator->state);
+  }
 }
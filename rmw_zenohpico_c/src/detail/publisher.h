@@ -1,7 +1,16 @@
 #ifndef RMW_ZENOHPICO_DETAIL__PUBLISHER_H_
 #define RMW_ZENOHPICO_DETAIL__PUBLISHER_H_
 
+#include <stdbool.h>
+
+#include "./atomic.h"
+#include "./attachment_helpers.h"
+#include "./deadline.h"
+#include "./events.h"
+#include "./loan_pool.h"
+#include "./timer_wheel.h"
 #include "./type_support.h"
+#include "rcutils/allocator.h"
 #include "rmw/init.h"
 #include "rmw/ret_types.h"
 #include "rmw/types.h"
@@ -24,15 +33,55 @@ typedef struct {
 
   uint8_t pub_gid[RMW_GID_STORAGE_SIZE];
 
+  // Attachment encoded once for pub_gid, patched with the sequence number and timestamp of each
+  // publication.
+  rmw_zp_attachment_template_t attachment_template;
+
+#if RMW_ZP_HAVE_ATOMICS
+  atomic_size_t sequence_number;
+#else
   z_owned_mutex_t sequence_number_mutex;
   size_t sequence_number;
+#endif
+
+  // Scratch buffer that messages are serialized into. It grows to fit the largest message seen so
+  // far, but never beyond serialization_buffer_max_size. Larger messages are serialized into a
+  // one-off allocation and counted in serialization_buffer_fallback_count. Messages published
+  // while another thread holds the buffer also get a one-off allocation, which is not counted, so
+  // that concurrent publications do not wait for each other's network send.
+  z_owned_mutex_t serialization_buffer_mutex;
+  uint8_t* serialization_buffer;
+  size_t serialization_buffer_capacity;
+  size_t serialization_buffer_max_size;
+  size_t serialization_buffer_fallback_count;
+
+  // Messages lent to the application through rmw_borrow_loaned_message. Only initialized if the
+  // introspection type support of the message is available, and only allocated on the first loan.
+  rmw_zp_loan_pool_t loan_pool;
+
+  rmw_zp_events_t events;
+
+  // Reports RMW_ZP_EVENT_OFFERED_DEADLINE_MISSED.
+  rmw_zp_deadline_t deadline;
 } rmw_zp_publisher_t;
 
 rmw_ret_t rmw_zp_publisher_init(rmw_zp_publisher_t* publisher,
-                                const rmw_qos_profile_t* qos_profile);
+                                const rmw_qos_profile_t* qos_profile,
+                                size_t serialization_buffer_max_size,
+                                rmw_zp_timer_wheel_t* timer_wheel);
 
-rmw_ret_t rmw_zp_publisher_fini(rmw_zp_publisher_t* publisher);
+rmw_ret_t rmw_zp_publisher_fini(rmw_zp_publisher_t* publisher, rcutils_allocator_t* allocator);
 
 size_t rmw_zp_publisher_get_next_sequence_number(rmw_zp_publisher_t* publisher);
 
-#endif
\ No newline at end of file
+// Get a buffer of at least `size` bytes to serialize a message into. Every buffer acquired this way
+// must be handed back with rmw_zp_publisher_release_serialization_buffer, passing the same
+// `is_shared`, which tells whether it is the shared buffer or a one-off allocation.
+uint8_t* rmw_zp_publisher_acquire_serialization_buffer(rmw_zp_publisher_t* publisher, size_t size,
+                                                       rcutils_allocator_t* allocator,
+                                                       bool* is_shared);
+
+void rmw_zp_publisher_release_serialization_buffer(rmw_zp_publisher_t* publisher, uint8_t* buffer,
+                                                   bool is_shared, rcutils_allocator_t* allocator);
+
+#endif
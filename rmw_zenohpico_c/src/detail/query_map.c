@@ -1,7 +1,11 @@
 #include "./query_map.h"
 
+#include <string.h>
+
 #include "rmw/error_handling.h"
 
+#define MIN_SLOT_COUNT 8
+
 static uint32_t get_query_id_hash(const int64_t sequence_number, const uint8_t* const writer_guid) {
   const uint32_t fnv_offset_basis = 0x811C9DC5UL;
   const uint32_t fnv_prime = 0x01000193UL;
@@ -22,31 +26,91 @@ static uint32_t get_query_id_hash(const int64_t sequence_number, const uint8_t*
   return hash;
 }
 
-static int get_index(rmw_zp_query_map_t* query_map, uint32_t key) {
-  for (size_t i = 0; i < query_map->capacity; i++) {
-    if (query_map->keys[i] == key) {
-      return i;
+static bool entry_matches(const rmw_zp_query_map_entry_t* entry, uint32_t hash,
+                          int64_t sequence_number, const uint8_t* writer_guid) {
+  return entry->hash == hash && entry->sequence_number == sequence_number &&
+         memcmp(entry->writer_guid, writer_guid, RMW_GID_STORAGE_SIZE) == 0;
+}
+
+// Slot of the entry with the given key, or of the empty slot ending its probe sequence.
+static size_t find_slot(const rmw_zp_query_map_t* query_map, uint32_t hash,
+                        int64_t sequence_number, const uint8_t* writer_guid) {
+  size_t i = hash & query_map->slot_mask;
+  while (query_map->entries[i].is_used &&
+         !entry_matches(&query_map->entries[i], hash, sequence_number, writer_guid)) {
+    i = (i + 1) & query_map->slot_mask;
+  }
+  return i;
+}
+
+static rmw_zp_query_map_entry_t* allocate_entries(size_t slot_count,
+                                                  rcutils_allocator_t* allocator) {
+  // zero_allocate leaves every is_used false.
+  return allocator->zero_allocate(slot_count, sizeof(rmw_zp_query_map_entry_t),
+                                  allocator->state);
+}
+
+static rmw_ret_t grow(rmw_zp_query_map_t* query_map, rcutils_allocator_t* allocator) {
+  const size_t old_slot_count = query_map->slot_mask + 1;
+  rmw_zp_query_map_entry_t* old_entries = query_map->entries;
+
+  rmw_zp_query_map_entry_t* entries = allocate_entries(old_slot_count * 2, allocator);
+  if (entries == NULL) {
+    RMW_SET_ERROR_MSG("Failed to grow query map");
+    return RMW_RET_BAD_ALLOC;
+  }
+
+  query_map->entries = entries;
+  query_map->slot_mask = old_slot_count * 2 - 1;
+
+  for (size_t i = 0; i < old_slot_count; i++) {
+    if (old_entries[i].is_used) {
+      size_t slot = old_entries[i].hash & query_map->slot_mask;
+      while (entries[slot].is_used) {
+        slot = (slot + 1) & query_map->slot_mask;
+      }
+      entries[slot] = old_entries[i];
     }
   }
-  return -1;
+
+  allocator->deallocate(old_entries, allocator->state);
+
+  return RMW_RET_OK;
 }
 
-rmw_ret_t rmw_zp_query_map_init(rmw_zp_query_map_t* query_map, size_t capacity,
-                                rcutils_allocator_t* allocator) {
-  query_map->capacity = capacity;
+// Empty the slot and shift back the entries that follow it in their probe sequences.
+static void remove_slot(rmw_zp_query_map_t* query_map, size_t hole) {
+  rmw_zp_query_map_entry_t* entries = query_map->entries;
+  const size_t mask = query_map->slot_mask;
 
-  query_map->keys = allocator->zero_allocate(capacity, sizeof(uint32_t), allocator->state);
+  entries[hole].is_used = false;
 
-  if (query_map->keys == NULL) {
-    RMW_SET_ERROR_MSG("Failed to allocate query map keys");
-    return RMW_RET_ERROR;
+  for (size_t i = (hole + 1) & mask; entries[i].is_used; i = (i + 1) & mask) {
+    // An entry can only move back if the hole lies between its home slot and its current slot.
+    const size_t home = entries[i].hash & mask;
+    if (((i - home) & mask) >= ((i - hole) & mask)) {
+      entries[hole] = entries[i];
+      entries[i].is_used = false;
+      hole = i;
+    }
   }
 
-  query_map->queries = allocator->allocate(capacity * sizeof(z_loaned_query_t), allocator->state);
+  query_map->size--;
+}
 
-  if (query_map->keys == NULL) {
-    RMW_SET_ERROR_MSG("Failed to allocate query map queries");
-    allocator->deallocate(query_map->keys, allocator->state);
+rmw_ret_t rmw_zp_query_map_init(rmw_zp_query_map_t* query_map, size_t capacity,
+                                rcutils_allocator_t* allocator) {
+  size_t slot_count = MIN_SLOT_COUNT;
+  while (slot_count < capacity * 2) {
+    slot_count <<= 1;
+  }
+
+  query_map->slot_mask = slot_count - 1;
+  query_map->size = 0;
+  query_map->entries = allocate_entries(slot_count, allocator);
+
+  if (query_map->entries == NULL) {
+    RMW_SET_ERROR_MSG("Failed to allocate query map entries");
     return RMW_RET_ERROR;
   }
 
@@ -54,57 +118,67 @@ rmw_ret_t rmw_zp_query_map_init(rmw_zp_query_map_t* query_map, size_t capacity,
 }
 
 rmw_ret_t rmw_zp_query_map_fini(rmw_zp_query_map_t* query_map, rcutils_allocator_t* allocator) {
-  if (query_map->keys != NULL) {
-    allocator->deallocate(query_map->keys, allocator->state);
+  if (query_map->entries != NULL) {
+    for (size_t i = 0; i <= query_map->slot_mask; i++) {
+      if (query_map->entries[i].is_used) {
+        _z_query_rc_drop(&query_map->entries[i].query);
+      }
+    }
+    allocator->deallocate(query_map->entries, allocator->state);
+    query_map->entries = NULL;
   }
 
-  if (query_map->queries != NULL) {
-    allocator->deallocate(query_map->queries, allocator->state);
-  }
+  query_map->size = 0;
 
   return RMW_RET_OK;
 }
 
 rmw_ret_t rmw_zp_query_map_insert(rmw_zp_query_map_t* query_map, const z_loaned_query_t* query,
-                                  int64_t sequence_number, const uint8_t* writer_guid) {
+                                  int64_t sequence_number, const uint8_t* writer_guid,
+                                  rcutils_allocator_t* allocator) {
   const uint32_t hash = get_query_id_hash(sequence_number, writer_guid);
 
-  if (hash == 0) {
-    RMW_SET_ERROR_MSG("Computed query id hash of value 0 is not allowed");
+  size_t slot = find_slot(query_map, hash, sequence_number, writer_guid);
+  if (query_map->entries[slot].is_used) {
+    RMW_SET_ERROR_MSG("Duplicate query id. Is the client incrementing sequence ids?");
     return RMW_RET_ERROR;
   }
 
-  int key_index = get_index(query_map, hash);
-  if (key_index != -1) {
-    RMW_SET_ERROR_MSG("Query id hash conflict. Is the client incrementing sequence ids?");
-    return RMW_RET_ERROR;
-  }
-
-  for (size_t i = 0; i < query_map->capacity; i++) {
-    if (query_map->keys[i] == 0) {
-      query_map->keys[i] = hash;
-      query_map->queries[i] = _z_query_rc_clone(query);
-      return RMW_RET_OK;
+  if ((query_map->size + 1) * 2 > query_map->slot_mask + 1) {
+    rmw_ret_t ret = grow(query_map, allocator);
+    if (ret != RMW_RET_OK) {
+      return ret;
     }
+    slot = find_slot(query_map, hash, sequence_number, writer_guid);
   }
 
-  RMW_SET_ERROR_MSG("Query map full");
-  return RMW_RET_ERROR;
+  rmw_zp_query_map_entry_t* entry = &query_map->entries[slot];
+  entry->sequence_number = sequence_number;
+  memcpy(entry->writer_guid, writer_guid, RMW_GID_STORAGE_SIZE);
+  entry->hash = hash;
+  entry->is_used = true;
+  entry->query = _z_query_rc_clone(query);
+  query_map->size++;
+
+  return RMW_RET_OK;
 }
 
 rmw_ret_t rmw_zp_query_map_extract(rmw_zp_query_map_t* query_map, int64_t sequence_number,
                                    const uint8_t* writer_guid, z_loaned_query_t* query) {
   const uint32_t hash = get_query_id_hash(sequence_number, writer_guid);
 
-  int key_index = get_index(query_map, hash);
-  if (key_index == -1) {
+  const size_t slot = find_slot(query_map, hash, sequence_number, writer_guid);
+  if (!query_map->entries[slot].is_used) {
     RMW_SET_ERROR_MSG("Could not find query in the query map");
     return RMW_RET_ERROR;
   }
 
-  query_map->keys[key_index] = 0;
-
-  *query = query_map->queries[key_index];
+  *query = query_map->entries[slot].query;
+  remove_slot(query_map, slot);
 
   return RMW_RET_OK;
+}
+
+size_t rmw_zp_query_map_size(const rmw_zp_query_map_t* query_map) {
+  return query_map->size;
 }
\ No newline at end of file
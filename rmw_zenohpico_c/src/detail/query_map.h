@@ -1,6 +1,7 @@
 #ifndef RMW_ZENOHPICO_DETAIL__QUERY_QUEUE_H_
 #define RMW_ZENOHPICO_DETAIL__QUERY_QUEUE_H_
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #include "rcutils/allocator.h"
@@ -8,20 +9,42 @@
 #include "zenoh-pico.h"
 
 typedef struct {
-  uint32_t* keys;
-  z_loaned_query_t* queries;
-  size_t capacity;
+  int64_t sequence_number;
+  uint8_t writer_guid[RMW_GID_STORAGE_SIZE];
+  uint32_t hash;
+  bool is_used;
+  z_loaned_query_t query;
+} rmw_zp_query_map_entry_t;
+
+// Queries waiting for a response, keyed by the sequence number and writer GUID of their request.
+//
+// Open addressing with linear probing over a power-of-two number of slots, kept at most half full
+// by doubling the slots when needed. Removed entries are filled by shifting the following entries
+// of their probe sequence backwards, so there are no tombstones and lookups stop at the first empty
+// slot.
+typedef struct {
+  rmw_zp_query_map_entry_t* entries;
+  // Number of slots minus one.
+  size_t slot_mask;
+  size_t size;
 } rmw_zp_query_map_t;
 
+// Allocate room for `capacity` queries. The map grows beyond that if needed.
 rmw_ret_t rmw_zp_query_map_init(rmw_zp_query_map_t* query_map, size_t capacity,
                                 rcutils_allocator_t* allocator);
 
+// Drops any queries left in the map.
 rmw_ret_t rmw_zp_query_map_fini(rmw_zp_query_map_t* query_map, rcutils_allocator_t* allocator);
 
+// Store a clone of the query. Fails if a query with the same key is already stored.
 rmw_ret_t rmw_zp_query_map_insert(rmw_zp_query_map_t* query_map, const z_loaned_query_t* query,
-                                  int64_t sequence_number, const uint8_t* writer_guid);
+                                  int64_t sequence_number, const uint8_t* writer_guid,
+                                  rcutils_allocator_t* allocator);
 
+// Move the query out of the map. The caller has to drop it.
 rmw_ret_t rmw_zp_query_map_extract(rmw_zp_query_map_t* query_map, int64_t sequence_number,
                                    const uint8_t* writer_guid, z_loaned_query_t* query);
 
+size_t rmw_zp_query_map_size(const rmw_zp_query_map_t* query_map);
+
 #endif
\ No newline at end of file
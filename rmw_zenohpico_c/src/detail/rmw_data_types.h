@@ -1,6 +1,8 @@
 #ifndef RMW_ZENOHPICO_DETAIL__RMW_DATA_TYPES_H_
 #define RMW_ZENOHPICO_DETAIL__RMW_DATA_TYPES_H_
 
+#include "./config.h"
+#include "./timer_wheel.h"
 #include "rmw/types.h"
 #include "zenoh-pico.h"
 
@@ -17,6 +19,15 @@ struct rmw_context_impl_s {
 
   // A counter to assign a local id for every entity created in this session.
   size_t next_entity_id;
+
+  // Tunables read from the environment when the context is initialized.
+  rmw_zp_config_t config;
+
+  // Drives the deadline QoS of every publisher and subscription of the context.
+  rmw_zp_timer_wheel_t timer_wheel;
+
+  // Serializes attaching entities to the wait sets of the context and detaching them.
+  z_owned_mutex_t attachment_mutex;
 };
 
 struct rmw_init_options_impl_s {
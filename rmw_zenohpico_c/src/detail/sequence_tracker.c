@@ -0,0 +1,46 @@
+#include "./sequence_tracker.h"
+
+#include <string.h>
+
+void rmw_zp_sequence_tracker_init(rmw_zp_sequence_tracker_t* tracker) {
+  tracker->size = 0;
+}
+
+size_t rmw_zp_sequence_tracker_update(rmw_zp_sequence_tracker_t* tracker,
+                                      const uint8_t* source_gid, int64_t sequence_number) {
+  rmw_zp_sequence_tracker_entry_t* entries = tracker->entries;
+
+  size_t i = 0;
+  for (; i < tracker->size; i++) {
+    if (memcmp(entries[i].source_gid, source_gid, RMW_GID_STORAGE_SIZE) == 0) {
+      break;
+    }
+  }
+
+  size_t skipped = 0;
+  if (i < tracker->size) {
+    if (sequence_number > entries[i].last_sequence_number) {
+      skipped = (size_t)(sequence_number - entries[i].last_sequence_number - 1);
+    }
+  } else {
+    // First message from this publisher, nothing to compare with. If the tracker is full, it
+    // takes the place of the publisher heard from the longest ago.
+    if (tracker->size < RMW_ZP_SEQUENCE_TRACKER_CAPACITY) {
+      tracker->size++;
+    } else {
+      i = tracker->size - 1;
+    }
+    memcpy(entries[i].source_gid, source_gid, RMW_GID_STORAGE_SIZE);
+  }
+
+  // Move the publisher to the front, so that busy publishers are found first and the quiet ones
+  // are the ones forgotten.
+  if (i > 0) {
+    rmw_zp_sequence_tracker_entry_t entry = entries[i];
+    memmove(&entries[1], &entries[0], i * sizeof(rmw_zp_sequence_tracker_entry_t));
+    entries[0] = entry;
+  }
+  entries[0].last_sequence_number = sequence_number;
+
+  return skipped;
+}
\ No newline at end of file
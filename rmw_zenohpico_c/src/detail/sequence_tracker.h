@@ -0,0 +1,33 @@
+#ifndef RMW_ZENOHPICO_DETAIL__SEQUENCE_TRACKER_H_
+#define RMW_ZENOHPICO_DETAIL__SEQUENCE_TRACKER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rmw/types.h"
+
+// Number of publishers whose sequence numbers a subscription keeps track of. When more publishers
+// are seen, the one that was heard from the longest ago is forgotten, and the first message seen
+// from a publisher again cannot tell whether messages were missed.
+#define RMW_ZP_SEQUENCE_TRACKER_CAPACITY 16
+
+typedef struct {
+  uint8_t source_gid[RMW_GID_STORAGE_SIZE];
+  int64_t last_sequence_number;
+} rmw_zp_sequence_tracker_entry_t;
+
+// Last sequence number received from each publisher, used to detect messages that never arrived.
+// The entries are ordered from the most to the least recently heard from publisher.
+typedef struct {
+  rmw_zp_sequence_tracker_entry_t entries[RMW_ZP_SEQUENCE_TRACKER_CAPACITY];
+  size_t size;
+} rmw_zp_sequence_tracker_t;
+
+void rmw_zp_sequence_tracker_init(rmw_zp_sequence_tracker_t* tracker);
+
+// Record a message and return how many messages of the same publisher were skipped before it.
+// Sequence numbers that go backwards (e.g. a restarted publisher) restart the tracking.
+size_t rmw_zp_sequence_tracker_update(rmw_zp_sequence_tracker_t* tracker,
+                                      const uint8_t* source_gid, int64_t sequence_number);
+
+#endif
\ No newline at end of file
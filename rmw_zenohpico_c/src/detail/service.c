@@ -1,17 +1,25 @@
 #include "./service.h"
 
+#include <string.h>
+
 #include "./attachment_helpers.h"
 #include "./qos.h"
 #include "rmw/error_handling.h"
 
 rmw_ret_t rmw_zp_service_init(rmw_zp_service_t* service, const rmw_qos_profile_t* qos_profile,
-                              rcutils_allocator_t* allocator) {
+                              size_t max_pending_queries, rcutils_allocator_t* allocator) {
   service->adapted_qos_profile = *qos_profile;
+  service->max_pending_queries = max_pending_queries;
+  service->rejected_request_count = 0;
+  service->request_queue_overflow_count = 0;
+  rmw_zp_waitable_init(&service->waitable);
 
   if (rmw_zp_adapt_qos_profile(&service->adapted_qos_profile) != RMW_RET_OK) {
     return RMW_RET_ERROR;
   }
 
+  rmw_zp_data_callback_init(&service->data_callback, service->adapted_qos_profile.depth);
+
   if (rmw_zp_message_queue_init(&service->message_queue, service->adapted_qos_profile.depth,
                                 allocator) != RMW_RET_OK) {
     return RMW_RET_ERROR;
@@ -22,9 +30,9 @@ rmw_ret_t rmw_zp_service_init(rmw_zp_service_t* service, const rmw_qos_profile_t
     goto fail_init_query_map;
   }
 
-  if (z_mutex_init(&service->message_queue_mutex) < 0) {
+  if (z_mutex_init(&service->query_map_mutex) < 0) {
     RMW_SET_ERROR_MSG("Failed to initialize zenohpico mutex");
-    goto fail_init_message_queue_mutex;
+    goto fail_init_query_map_mutex;
   }
 
   if (z_mutex_init(&service->condition_mutex) < 0) {
@@ -35,8 +43,8 @@ rmw_ret_t rmw_zp_service_init(rmw_zp_service_t* service, const rmw_qos_profile_t
   return RMW_RET_OK;
 
 fail_init_condition_mutex:
-  z_drop(z_move(service->message_queue_mutex));
-fail_init_message_queue_mutex:
+  z_drop(z_move(service->query_map_mutex));
+fail_init_query_map_mutex:
   rmw_zp_query_map_fini(&service->query_map, allocator);
 fail_init_query_map:
   rmw_zp_message_queue_fini(&service->message_queue, allocator);
@@ -46,12 +54,14 @@ fail_init_query_map:
 rmw_ret_t rmw_zp_service_fini(rmw_zp_service_t* service, rcutils_allocator_t* allocator) {
   rmw_ret_t ret = RMW_RET_OK;
 
+  rmw_zp_waitable_fini(&service->waitable, &service->condition_mutex);
+
   if (z_drop(z_move(service->condition_mutex)) < 0) {
     RMW_SET_ERROR_MSG("Failed to drop zenohpico mutex");
     ret = RMW_RET_ERROR;
   }
 
-  if (z_drop(z_move(service->message_queue_mutex)) < 0) {
+  if (z_drop(z_move(service->query_map_mutex)) < 0) {
     RMW_SET_ERROR_MSG("Failed to drop zenohpico mutex");
     ret = RMW_RET_ERROR;
   }
@@ -87,37 +97,77 @@ void rmw_zp_service_data_handler(z_loaned_query_t* query, void* data) {
   }
 }
 
+// Answer a request that will never be taken, so that the client does not wait for it in vain.
+static void reply_error(const z_loaned_query_t* query, const char* reason) {
+  z_owned_bytes_t payload;
+  z_bytes_from_static_buf(&payload, (const uint8_t*)reason, strlen(reason));
+
+  z_query_reply_err_options_t opts;
+  z_query_reply_err_options_default(&opts);
+
+  if (z_query_reply_err(query, z_move(payload), &opts) < 0) {
+    // TODO(bjsowa): report error
+  }
+}
+
+// Release the query of a request dropped from the full request queue.
+static void reject_dropped_request(rmw_zp_service_t* service, rmw_zp_message_t* message) {
+  z_loaned_query_t query;
+
+  z_mutex_lock(z_loan_mut(service->query_map_mutex));
+  rmw_ret_t ret = rmw_zp_query_map_extract(&service->query_map,
+                                           message->attachment_data.sequence_number,
+                                           message->attachment_data.source_gid, &query);
+  service->request_queue_overflow_count++;
+  z_mutex_unlock(z_loan_mut(service->query_map_mutex));
+
+  rmw_zp_message_fini(message);
+
+  if (ret == RMW_RET_OK) {
+    reply_error(&query, "Request dropped because the request queue of the service is full");
+    _z_query_rc_drop(&query);
+  }
+}
+
 rmw_ret_t rmw_zp_service_add_new_query(rmw_zp_service_t* service,
                                        const z_loaned_bytes_t* attachment,
                                        const z_loaned_bytes_t* payload,
                                        const z_loaned_query_t* query) {
-  z_mutex_lock(z_loan_mut(service->message_queue_mutex));
-
-  if (service->message_queue.size >= service->adapted_qos_profile.depth) {
-    // TODO(bjsowa): Log warning if message is discarded due to hitting the queue depth
-
-    // Adapted QoS has depth guaranteed to be >= 1
-    if (rmw_zp_message_queue_pop_front(&service->message_queue, NULL) != RMW_RET_OK) {
-      z_mutex_unlock(z_loan_mut(service->message_queue_mutex));
-      return RMW_RET_ERROR;
-    }
+  rmw_zp_message_t message;
+  if (rmw_zp_message_init(&message, attachment, payload) != RMW_RET_OK) {
+    return RMW_RET_ERROR;
   }
 
-  const rmw_zp_message_t* message;
+  // The query has to be in the map before the request can be taken, as the response may be sent
+  // right after.
+  z_mutex_lock(z_loan_mut(service->query_map_mutex));
 
-  if (rmw_zp_message_queue_push_back(&service->message_queue, attachment, payload, &message) !=
-      RMW_RET_OK) {
-    z_mutex_unlock(z_loan_mut(service->message_queue_mutex));
-    return RMW_RET_ERROR;
+  if (service->max_pending_queries > 0 &&
+      rmw_zp_query_map_size(&service->query_map) >= service->max_pending_queries) {
+    service->rejected_request_count++;
+    z_mutex_unlock(z_loan_mut(service->query_map_mutex));
+    rmw_zp_message_fini(&message);
+    reply_error(query, "Request rejected because the service has too many pending requests");
+    return RMW_RET_OK;
   }
 
-  if (rmw_zp_query_map_insert(&service->query_map, query, message->attachment_data.sequence_number,
-                              message->attachment_data.source_gid) < 0) {
-    // TODO(bjsowa): pop the message pushed to message queue
+  if (rmw_zp_query_map_insert(&service->query_map, query, message.attachment_data.sequence_number,
+                              message.attachment_data.source_gid,
+                              &service->context->options.allocator) != RMW_RET_OK) {
+    service->rejected_request_count++;
+    z_mutex_unlock(z_loan_mut(service->query_map_mutex));
+    rmw_zp_message_fini(&message);
+    reply_error(query, "Request rejected because it could not be stored by the service");
     return RMW_RET_ERROR;
   }
 
-  z_mutex_unlock(z_loan_mut(service->message_queue_mutex));
+  z_mutex_unlock(z_loan_mut(service->query_map_mutex));
+
+  // The oldest request is discarded when hitting the queue depth.
+  rmw_zp_message_t dropped_message;
+  if (rmw_zp_message_queue_push_back(&service->message_queue, &message, &dropped_message)) {
+    reject_dropped_request(service, &dropped_message);
+  }
 
   rmw_zp_service_notify(service);
 
@@ -125,75 +175,59 @@ rmw_ret_t rmw_zp_service_add_new_query(rmw_zp_service_t* service,
 }
 
 rmw_ret_t rmw_zp_service_pop_next_query(rmw_zp_service_t* service, rmw_zp_message_t* query_data) {
-  z_mutex_lock(z_loan_mut(service->message_queue_mutex));
-
-  if (service->message_queue.size == 0) {
+  if (!rmw_zp_message_queue_pop_front(&service->message_queue, query_data)) {
     RMW_SET_ERROR_MSG("Trying to pop message from empty message queue");
-    z_mutex_unlock(z_loan_mut(service->message_queue_mutex));
-    return RMW_RET_ERROR;
-  }
-
-  if (rmw_zp_message_queue_pop_front(&service->message_queue, query_data) != RMW_RET_OK) {
-    z_mutex_unlock(z_loan_mut(service->message_queue_mutex));
     return RMW_RET_ERROR;
   }
 
-  z_mutex_unlock(z_loan_mut(service->message_queue_mutex));
-
   return RMW_RET_OK;
 }
 
 rmw_ret_t rmw_zp_service_take_from_query_map(rmw_zp_service_t* service,
                                              const rmw_request_id_t* request_header,
                                              z_loaned_query_t* query) {
-  z_mutex_lock(z_loan_mut(service->message_queue_mutex));
+  z_mutex_lock(z_loan_mut(service->query_map_mutex));
 
   if (rmw_zp_query_map_extract(&service->query_map, request_header->sequence_number,
                                request_header->writer_guid, query) != RMW_RET_OK) {
-    z_mutex_unlock(z_loan_mut(service->message_queue_mutex));
+    z_mutex_unlock(z_loan_mut(service->query_map_mutex));
     return RMW_RET_ERROR;
   }
 
-  z_mutex_unlock(z_loan_mut(service->message_queue_mutex));
+  z_mutex_unlock(z_loan_mut(service->query_map_mutex));
 
   return RMW_RET_OK;
 }
 
-bool rmw_zp_service_queue_has_data_and_attach_condition_if_not(rmw_zp_service_t* service,
-                                                               rmw_zp_wait_set_t* wait_set) {
+rmw_ret_t rmw_zp_service_attach(rmw_zp_service_t* service,
+                                rmw_zp_wait_set_attachment_t* attachment) {
   z_mutex_lock(z_loan_mut(service->condition_mutex));
 
-  if (service->message_queue.size > 0) {
-    z_mutex_unlock(z_loan_mut(service->condition_mutex));
-    return true;
-  }
-
-  service->wait_set_data = wait_set;
+  rmw_ret_t ret = rmw_zp_waitable_attach(&service->waitable, &service->condition_mutex,
+                                         attachment, rmw_zp_service_has_data(service));
 
   z_mutex_unlock(z_loan_mut(service->condition_mutex));
 
-  return false;
+  return ret;
+}
+
+bool rmw_zp_service_has_data(rmw_zp_service_t* service) {
+  return !rmw_zp_message_queue_is_empty(&service->message_queue);
 }
 
 void rmw_zp_service_notify(rmw_zp_service_t* service) {
   z_mutex_lock(z_loan_mut(service->condition_mutex));
 
-  if (service->wait_set_data != NULL) {
-    z_mutex_lock(z_loan_mut(service->wait_set_data->condition_mutex));
-    service->wait_set_data->triggered = true;
-    z_condvar_signal(z_loan_mut(service->wait_set_data->condition_variable));
-    z_mutex_unlock(z_loan_mut(service->wait_set_data->condition_mutex));
-  }
+  rmw_zp_waitable_notify(&service->waitable);
+
+  rmw_zp_data_callback_trigger(&service->data_callback, 1);
 
   z_mutex_unlock(z_loan_mut(service->condition_mutex));
 }
 
-bool rmw_zp_service_detach_condition_and_queue_is_empty(rmw_zp_service_t* service) {
+void rmw_zp_service_set_data_callback(rmw_zp_service_t* service, rmw_event_callback_t callback,
+                                      const void* user_data) {
   z_mutex_lock(z_loan_mut(service->condition_mutex));
-
-  service->wait_set_data = NULL;
-
+  rmw_zp_data_callback_set(&service->data_callback, callback, user_data);
   z_mutex_unlock(z_loan_mut(service->condition_mutex));
-
-  return service->message_queue.size == 0;
-}
+}
\ No newline at end of file
@@ -1,6 +1,7 @@
 #ifndef RMW_ZENOHPICO_DETAIL__SERVICE_H_
 #define RMW_ZENOHPICO_DETAIL__SERVICE_H_
 
+#include "./data_callback.h"
 #include "./message_queue.h"
 #include "./query_map.h"
 #include "./type_support.h"
@@ -24,15 +25,27 @@ typedef struct {
   rmw_context_t* context;
 
   rmw_zp_message_queue_t message_queue;
+
+  // Queries of the requests that were received but not responded to yet, at most
+  // max_pending_queries of them (0 for no limit).
   rmw_zp_query_map_t query_map;
-  z_owned_mutex_t message_queue_mutex;
+  z_owned_mutex_t query_map_mutex;
+  size_t max_pending_queries;
+
+  // Requests answered with an error reply because max_pending_queries was reached, and because
+  // they were dropped from the full message_queue before being taken. Guarded by query_map_mutex.
+  size_t rejected_request_count;
+  size_t request_queue_overflow_count;
 
-  rmw_zp_wait_set_t* wait_set_data;
+  rmw_zp_waitable_t waitable;
   z_owned_mutex_t condition_mutex;
+
+  // Guarded by condition_mutex.
+  rmw_zp_data_callback_t data_callback;
 } rmw_zp_service_t;
 
 rmw_ret_t rmw_zp_service_init(rmw_zp_service_t* service, const rmw_qos_profile_t* qos_profile,
-                              rcutils_allocator_t* allocator);
+                              size_t max_pending_queries, rcutils_allocator_t* allocator);
 
 rmw_ret_t rmw_zp_service_fini(rmw_zp_service_t* service, rcutils_allocator_t* allocator);
 
@@ -49,11 +62,14 @@ rmw_ret_t rmw_zp_service_take_from_query_map(rmw_zp_service_t* service,
                                              const rmw_request_id_t* request_header,
                                              z_loaned_query_t* query);
 
-bool rmw_zp_service_queue_has_data_and_attach_condition_if_not(rmw_zp_service_t* service,
-                                                               rmw_zp_wait_set_t* wait_set);
+rmw_ret_t rmw_zp_service_attach(rmw_zp_service_t* service,
+                                rmw_zp_wait_set_attachment_t* attachment);
+
+bool rmw_zp_service_has_data(rmw_zp_service_t* service);
 
 void rmw_zp_service_notify(rmw_zp_service_t* service);
 
-bool rmw_zp_service_detach_condition_and_queue_is_empty(rmw_zp_service_t* service);
+void rmw_zp_service_set_data_callback(rmw_zp_service_t* service, rmw_event_callback_t callback,
+                                      const void* user_data);
 
 #endif
\ No newline at end of file
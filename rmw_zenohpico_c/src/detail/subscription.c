@@ -3,25 +3,34 @@
 #include "./attachment_helpers.h"
 #include "./message_queue.h"
 #include "./qos.h"
+#include "./time.h"
 #include "rmw/error_handling.h"
 #include "zenoh-pico.h"
 
 rmw_ret_t rmw_zp_subscription_init(rmw_zp_subscription_t* subscription,
                                    const rmw_qos_profile_t* qos_profile,
-                                   rcutils_allocator_t* allocator) {
+                                   rcutils_allocator_t* allocator,
+                                   rmw_zp_timer_wheel_t* timer_wheel) {
   subscription->adapted_qos_profile = *qos_profile;
+  rmw_zp_waitable_init(&subscription->waitable);
+  rmw_zp_sequence_tracker_init(&subscription->sequence_tracker);
+  subscription->queue_overflow_count = 0;
+  subscription->sequence_gap_count = 0;
+  subscription->lifespan_expired_count = 0;
   if (rmw_zp_adapt_qos_profile(&subscription->adapted_qos_profile) != RMW_RET_OK) {
     return RMW_RET_ERROR;
   }
 
-  if (z_mutex_init(&subscription->message_queue_mutex) < 0) {
-    RMW_SET_ERROR_MSG("Failed to initialize zenohpico mutex");
-    return RMW_RET_ERROR;
+  rmw_zp_data_callback_init(&subscription->data_callback, subscription->adapted_qos_profile.depth);
+
+  subscription->lifespan = rmw_zp_duration_to_timestamp(subscription->adapted_qos_profile.lifespan);
+  if (subscription->lifespan == 0) {
+    subscription->lifespan = INT64_MAX;
   }
 
   if (rmw_zp_message_queue_init(&subscription->message_queue,
                                 subscription->adapted_qos_profile.depth, allocator) != RMW_RET_OK) {
-    goto fail_init_message_queue;
+    return RMW_RET_ERROR;
   }
 
   if (z_mutex_init(&subscription->condition_mutex) < 0) {
@@ -29,12 +38,20 @@ rmw_ret_t rmw_zp_subscription_init(rmw_zp_subscription_t* subscription,
     goto fail_init_condition_mutex;
   }
 
+  if (rmw_zp_events_init(&subscription->events) != RMW_RET_OK) {
+    goto fail_init_events;
+  }
+
+  rmw_zp_deadline_init(&subscription->deadline, timer_wheel,
+                       subscription->adapted_qos_profile.deadline, &subscription->events,
+                       RMW_ZP_EVENT_REQUESTED_DEADLINE_MISSED);
+
   return RMW_RET_OK;
 
+fail_init_events:
+  z_drop(z_move(subscription->condition_mutex));
 fail_init_condition_mutex:
   rmw_zp_message_queue_fini(&subscription->message_queue, allocator);
-fail_init_message_queue:
-  z_drop(z_move(subscription->message_queue_mutex));
   return RMW_RET_ERROR;
 }
 
@@ -42,20 +59,27 @@ rmw_ret_t rmw_zp_subscription_fini(rmw_zp_subscription_t* subscription,
                                    rcutils_allocator_t* allocator) {
   rmw_ret_t ret = RMW_RET_OK;
 
-  if (z_drop(z_move(subscription->condition_mutex)) < 0) {
-    RMW_SET_ERROR_MSG("Failed to drop zenohpico mutex");
+  rmw_zp_deadline_fini(&subscription->deadline);
+
+  if (rmw_zp_loan_pool_fini(&subscription->loan_pool) != RMW_RET_OK) {
     ret = RMW_RET_ERROR;
   }
 
-  if (rmw_zp_message_queue_fini(&subscription->message_queue, allocator) != RMW_RET_OK) {
+  if (rmw_zp_events_fini(&subscription->events) != RMW_RET_OK) {
     ret = RMW_RET_ERROR;
   }
 
-  if (z_drop(z_move(subscription->message_queue_mutex)) < 0) {
+  rmw_zp_waitable_fini(&subscription->waitable, &subscription->condition_mutex);
+
+  if (z_drop(z_move(subscription->condition_mutex)) < 0) {
     RMW_SET_ERROR_MSG("Failed to drop zenohpico mutex");
     ret = RMW_RET_ERROR;
   }
 
+  if (rmw_zp_message_queue_fini(&subscription->message_queue, allocator) != RMW_RET_OK) {
+    ret = RMW_RET_ERROR;
+  }
+
   return ret;
 }
 
@@ -82,86 +106,164 @@ void rmw_zp_sub_data_handler(z_loaned_sample_t* sample, void* data) {
 rmw_ret_t rmw_zp_subscription_add_new_message(rmw_zp_subscription_t* subscription,
                                               const z_loaned_bytes_t* attachment,
                                               const z_loaned_bytes_t* payload) {
-  z_mutex_lock(z_loan_mut(subscription->message_queue_mutex));
+  rmw_zp_message_t message;
+  if (rmw_zp_message_init(&message, attachment, payload) != RMW_RET_OK) {
+    return RMW_RET_ERROR;
+  }
 
-  if (subscription->message_queue.size >= subscription->adapted_qos_profile.depth) {
-    // TODO(bjsowa): Log warning if message is discarded due to hitting the queue depth
+  rmw_zp_deadline_record_activity(&subscription->deadline);
 
-    // Adapted QoS has depth guaranteed to be >= 1
-    if (rmw_zp_message_queue_pop_front(&subscription->message_queue, NULL) != RMW_RET_OK) {
-      z_mutex_unlock(z_loan_mut(subscription->message_queue_mutex));
-      return RMW_RET_ERROR;
-    }
+  size_t skipped = rmw_zp_sequence_tracker_update(&subscription->sequence_tracker,
+                                                  message.attachment_data.source_gid,
+                                                  message.attachment_data.sequence_number);
+
+  // Messages that already outlived their lifespan are not queued. The ones that expired while
+  // waiting at the front of the queue are evicted as well, so that they are not taken later.
+  size_t expired = 0;
+  bool is_expired = false;
+  if (subscription->lifespan != INT64_MAX) {
+    const int64_t min_source_timestamp = message.received_timestamp - subscription->lifespan;
+    expired = rmw_zp_message_queue_drop_expired(&subscription->message_queue, min_source_timestamp);
+    is_expired = message.attachment_data.source_timestamp < min_source_timestamp;
   }
 
-  if (rmw_zp_message_queue_push_back(&subscription->message_queue, attachment, payload, NULL) !=
-      RMW_RET_OK) {
-    z_mutex_unlock(z_loan_mut(subscription->message_queue_mutex));
-    return RMW_RET_ERROR;
+  bool overflowed = false;
+  if (is_expired) {
+    rmw_zp_message_fini(&message);
+    expired++;
+  } else {
+    // The oldest message is discarded when hitting the queue depth.
+    overflowed = rmw_zp_message_queue_push_back(&subscription->message_queue, &message, NULL);
+
+    rmw_zp_subscription_notify(subscription);
   }
 
-  z_mutex_unlock(z_loan_mut(subscription->message_queue_mutex));
+  if (skipped > 0 || overflowed || expired > 0) {
+    z_mutex_lock(z_loan_mut(subscription->condition_mutex));
+    subscription->sequence_gap_count += skipped;
+    subscription->queue_overflow_count += overflowed ? 1 : 0;
+    subscription->lifespan_expired_count += expired;
+    z_mutex_unlock(z_loan_mut(subscription->condition_mutex));
+  }
 
-  rmw_zp_subscription_notify(subscription);
+  if (skipped > 0 || overflowed) {
+    rmw_zp_events_add(&subscription->events, RMW_ZP_EVENT_MESSAGE_LOST,
+                      skipped + (overflowed ? 1 : 0));
+  }
 
   return RMW_RET_OK;
 }
 
-rmw_ret_t rmw_zp_subscription_pop_next_message(rmw_zp_subscription_t* subscription,
-                                               rmw_zp_message_t* msg_data) {
-  z_mutex_lock(z_loan_mut(subscription->message_queue_mutex));
-
-  if (subscription->message_queue.size == 0) {
-    RMW_SET_ERROR_MSG("Trying to pop message from empty message queue");
-    z_mutex_unlock(z_loan_mut(subscription->message_queue_mutex));
-    return RMW_RET_ERROR;
+// Source timestamp below which queued messages have outlived the lifespan. Returns false if the
+// lifespan is infinite.
+static bool get_min_source_timestamp(rmw_zp_subscription_t* subscription,
+                                     int64_t* min_source_timestamp) {
+  if (subscription->lifespan == INT64_MAX) {
+    return false;
   }
 
-  if (rmw_zp_message_queue_pop_front(&subscription->message_queue, msg_data) != RMW_RET_OK) {
-    z_mutex_unlock(z_loan_mut(subscription->message_queue_mutex));
-    return RMW_RET_ERROR;
+  int64_t now;
+  if (rmw_zp_get_current_timestamp(&now) != RMW_RET_OK) {
+    return false;
   }
 
-  z_mutex_unlock(z_loan_mut(subscription->message_queue_mutex));
+  *min_source_timestamp = now - subscription->lifespan;
+  return true;
+}
 
-  return RMW_RET_OK;
+static void add_lifespan_expired(rmw_zp_subscription_t* subscription, size_t expired) {
+  if (expired > 0) {
+    z_mutex_lock(z_loan_mut(subscription->condition_mutex));
+    subscription->lifespan_expired_count += expired;
+    z_mutex_unlock(z_loan_mut(subscription->condition_mutex));
+  }
 }
 
-bool rmw_zp_subscription_queue_has_data_and_attach_condition_if_not(
-    rmw_zp_subscription_t* subscription, rmw_zp_wait_set_t* wait_set) {
-  z_mutex_lock(z_loan_mut(subscription->condition_mutex));
+bool rmw_zp_subscription_pop_next_message(rmw_zp_subscription_t* subscription,
+                                          rmw_zp_message_t* msg_data) {
+  int64_t min_source_timestamp;
+  const bool check_lifespan = get_min_source_timestamp(subscription, &min_source_timestamp);
+
+  size_t expired = 0;
+  bool popped = false;
+  while (rmw_zp_message_queue_pop_front(&subscription->message_queue, msg_data)) {
+    if (!check_lifespan || msg_data->attachment_data.source_timestamp >= min_source_timestamp) {
+      popped = true;
+      break;
+    }
+    rmw_zp_message_fini(msg_data);
+    expired++;
+  }
 
-  if (subscription->message_queue.size > 0) {
-    z_mutex_unlock(z_loan_mut(subscription->condition_mutex));
-    return true;
+  add_lifespan_expired(subscription, expired);
+
+  return popped;
+}
+
+size_t rmw_zp_subscription_pop_messages(rmw_zp_subscription_t* subscription,
+                                        rmw_zp_message_t* msg_data, size_t count) {
+  int64_t min_source_timestamp;
+  if (!get_min_source_timestamp(subscription, &min_source_timestamp)) {
+    return rmw_zp_message_queue_pop_front_n(&subscription->message_queue, msg_data, count);
   }
 
-  subscription->wait_set_data = wait_set;
+  // Expired messages are dropped and the remaining ones moved down, until `count` messages are
+  // kept or the queue is empty.
+  size_t expired = 0;
+  size_t n = 0;
+  while (n < count) {
+    size_t popped =
+        rmw_zp_message_queue_pop_front_n(&subscription->message_queue, &msg_data[n], count - n);
+    if (popped == 0) {
+      break;
+    }
 
-  z_mutex_unlock(z_loan_mut(subscription->condition_mutex));
+    const size_t end = n + popped;
+    for (size_t i = n; i < end; i++) {
+      if (msg_data[i].attachment_data.source_timestamp < min_source_timestamp) {
+        rmw_zp_message_fini(&msg_data[i]);
+        expired++;
+      } else {
+        msg_data[n++] = msg_data[i];
+      }
+    }
+  }
 
-  return false;
+  add_lifespan_expired(subscription, expired);
+
+  return n;
 }
 
-void rmw_zp_subscription_notify(rmw_zp_subscription_t* subscription) {
+rmw_ret_t rmw_zp_subscription_attach(rmw_zp_subscription_t* subscription,
+                                     rmw_zp_wait_set_attachment_t* attachment) {
   z_mutex_lock(z_loan_mut(subscription->condition_mutex));
 
-  if (subscription->wait_set_data != NULL) {
-    z_mutex_lock(z_loan_mut(subscription->wait_set_data->condition_mutex));
-    subscription->wait_set_data->triggered = true;
-    z_condvar_signal(z_loan_mut(subscription->wait_set_data->condition_variable));
-    z_mutex_unlock(z_loan_mut(subscription->wait_set_data->condition_mutex));
-  }
+  rmw_ret_t ret =
+      rmw_zp_waitable_attach(&subscription->waitable, &subscription->condition_mutex, attachment,
+                             rmw_zp_subscription_has_data(subscription));
 
   z_mutex_unlock(z_loan_mut(subscription->condition_mutex));
+
+  return ret;
 }
 
-bool rmw_zp_subscription_detach_condition_and_queue_is_empty(rmw_zp_subscription_t* subscription) {
+bool rmw_zp_subscription_has_data(rmw_zp_subscription_t* subscription) {
+  return !rmw_zp_message_queue_is_empty(&subscription->message_queue);
+}
+
+void rmw_zp_subscription_notify(rmw_zp_subscription_t* subscription) {
   z_mutex_lock(z_loan_mut(subscription->condition_mutex));
 
-  subscription->wait_set_data = NULL;
+  rmw_zp_waitable_notify(&subscription->waitable);
+
+  rmw_zp_data_callback_trigger(&subscription->data_callback, 1);
 
   z_mutex_unlock(z_loan_mut(subscription->condition_mutex));
+}
 
-  return subscription->message_queue.size == 0;
+void rmw_zp_subscription_set_data_callback(rmw_zp_subscription_t* subscription,
+                                           rmw_event_callback_t callback, const void* user_data) {
+  z_mutex_lock(z_loan_mut(subscription->condition_mutex));
+  rmw_zp_data_callback_set(&subscription->data_callback, callback, user_data);
+  z_mutex_unlock(z_loan_mut(subscription->condition_mutex));
 }
\ No newline at end of file
@@ -4,7 +4,13 @@
 #include <stdint.h>
 
 #include "./attachment_helpers.h"
+#include "./data_callback.h"
+#include "./deadline.h"
+#include "./events.h"
+#include "./loan_pool.h"
 #include "./message_queue.h"
+#include "./sequence_tracker.h"
+#include "./timer_wheel.h"
 #include "./type_support.h"
 #include "./wait_set.h"
 #include "rmw/ret_types.h"
@@ -25,15 +31,42 @@ typedef struct {
   rmw_context_t* context;
 
   rmw_zp_message_queue_t message_queue;
-  z_owned_mutex_t message_queue_mutex;
 
-  rmw_zp_wait_set_t* wait_set_data;
+  // Messages that received data is deserialized into and lent to the application through
+  // rmw_take_loaned_message. Only initialized if the introspection type support of the message is
+  // available and supports all of its members, and only allocated on the first loan.
+  rmw_zp_loan_pool_t loan_pool;
+
+  rmw_zp_waitable_t waitable;
   z_owned_mutex_t condition_mutex;
+
+  // Guarded by condition_mutex.
+  rmw_zp_data_callback_t data_callback;
+
+  rmw_zp_events_t events;
+
+  // Reports RMW_ZP_EVENT_REQUESTED_DEADLINE_MISSED.
+  rmw_zp_deadline_t deadline;
+
+  // Only accessed by the data handler.
+  rmw_zp_sequence_tracker_t sequence_tracker;
+
+  // Messages lost because the queue was full, and because they never arrived. Both are also
+  // reported as RMW_EVENT_MESSAGE_LOST. Guarded by condition_mutex.
+  size_t queue_overflow_count;
+  size_t sequence_gap_count;
+
+  // Lifespan QoS in timestamp units, INT64_MAX if infinite. Messages whose source timestamp is
+  // older than that are dropped without being deserialized, and counted in lifespan_expired_count
+  // (guarded by condition_mutex).
+  int64_t lifespan;
+  size_t lifespan_expired_count;
 } rmw_zp_subscription_t;
 
 rmw_ret_t rmw_zp_subscription_init(rmw_zp_subscription_t* subscription,
                                    const rmw_qos_profile_t* qos_profile,
-                                   rcutils_allocator_t* allocator);
+                                   rcutils_allocator_t* allocator,
+                                   rmw_zp_timer_wheel_t* timer_wheel);
 
 rmw_ret_t rmw_zp_subscription_fini(rmw_zp_subscription_t* subscription,
                                    rcutils_allocator_t* allocator);
@@ -44,14 +77,23 @@ rmw_ret_t rmw_zp_subscription_add_new_message(rmw_zp_subscription_t* subscriptio
                                               const z_loaned_bytes_t* attachment,
                                               const z_loaned_bytes_t* payload);
 
-rmw_ret_t rmw_zp_subscription_pop_next_message(rmw_zp_subscription_t* subscription,
-                                               rmw_zp_message_t* msg_data);
+// Pop the oldest message that has not outlived its lifespan. Returns false if there is none.
+bool rmw_zp_subscription_pop_next_message(rmw_zp_subscription_t* subscription,
+                                          rmw_zp_message_t* msg_data);
+
+// Pop up to `count` messages at once, skipping the ones that outlived their lifespan. Returns the
+// number of messages popped, which is 0 if the queue is empty.
+size_t rmw_zp_subscription_pop_messages(rmw_zp_subscription_t* subscription,
+                                        rmw_zp_message_t* msg_data, size_t count);
+
+rmw_ret_t rmw_zp_subscription_attach(rmw_zp_subscription_t* subscription,
+                                     rmw_zp_wait_set_attachment_t* attachment);
 
-bool rmw_zp_subscription_queue_has_data_and_attach_condition_if_not(
-    rmw_zp_subscription_t* subscription, rmw_zp_wait_set_t* wait_set);
+bool rmw_zp_subscription_has_data(rmw_zp_subscription_t* subscription);
 
 void rmw_zp_subscription_notify(rmw_zp_subscription_t* subscription);
 
-bool rmw_zp_subscription_detach_condition_and_queue_is_empty(rmw_zp_subscription_t* subscription);
+void rmw_zp_subscription_set_data_callback(rmw_zp_subscription_t* subscription,
+                                           rmw_event_callback_t callback, const void* user_data);
 
 #endif
\ No newline at end of file
@@ -13,4 +13,15 @@ rmw_ret_t rmw_zp_get_current_timestamp(int64_t *timestamp) {
   *timestamp = _z_timestamp_ntp64_from_time(time_since_epoch.secs, time_since_epoch.nanos);
 
   return RMW_RET_OK;
+}
+
+int64_t rmw_zp_duration_to_timestamp(rmw_time_t duration) {
+  const uint64_t nanos_per_sec = 1000000000;
+  uint64_t secs = duration.sec + duration.nsec / nanos_per_sec;
+  uint64_t nanos = duration.nsec % nanos_per_sec;
+  if (secs >= ((uint64_t)1 << 31)) {
+    return INT64_MAX;
+  }
+
+  return (int64_t)((secs << 32) + (nanos << 32) / nanos_per_sec);
 }
\ No newline at end of file
@@ -1,8 +1,17 @@
 #ifndef RMW_ZENOHPICO_DETAIL__TIME_H_
 #define RMW_ZENOHPICO_DETAIL__TIME_H_
 
+#include <stdint.h>
+
 #include "rmw/ret_types.h"
+#include "rmw/time.h"
 
+// Timestamps are NTP64 times since the Unix epoch: seconds in the upper 32 bits, fractions of a
+// second in the lower 32 bits.
 rmw_ret_t rmw_zp_get_current_timestamp(int64_t *timestamp);
 
+// Convert a duration to the unit of timestamps, so that it can be compared to their difference.
+// Durations that do not fit, like RMW_DURATION_INFINITE, are clamped to INT64_MAX.
+int64_t rmw_zp_duration_to_timestamp(rmw_time_t duration);
+
 #endif
\ No newline at end of file
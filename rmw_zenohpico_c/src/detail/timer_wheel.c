@@ -0,0 +1,228 @@
+#include "./timer_wheel.h"
+
+#include "rmw/error_handling.h"
+
+#define SLOT_MASK (RMW_ZP_TIMER_WHEEL_SLOT_COUNT - 1)
+
+// Must be called with the mutex held.
+static void link_timer(rmw_zp_timer_wheel_t* wheel, rmw_zp_timer_t* timer) {
+  rmw_zp_timer_t** slot = &wheel->slots[timer->expiry_tick & SLOT_MASK];
+  timer->prev = NULL;
+  timer->next = *slot;
+  if (*slot != NULL) {
+    (*slot)->prev = timer;
+  }
+  *slot = timer;
+}
+
+// Must be called with the mutex held.
+static void unlink_timer(rmw_zp_timer_wheel_t* wheel, rmw_zp_timer_t* timer) {
+  if (timer->prev != NULL) {
+    timer->prev->next = timer->next;
+  } else {
+    wheel->slots[timer->expiry_tick & SLOT_MASK] = timer->next;
+  }
+  if (timer->next != NULL) {
+    timer->next->prev = timer->prev;
+  }
+  timer->prev = NULL;
+  timer->next = NULL;
+}
+
+// Must be called with the mutex held. Timers never go into a tick that was already processed.
+static uint64_t expiry_to_tick(rmw_zp_timer_wheel_t* wheel, uint64_t expiry_us) {
+  uint64_t tick = (expiry_us + wheel->tick_us - 1) / wheel->tick_us;
+  return tick > wheel->next_tick ? tick : wheel->next_tick;
+}
+
+// Must be called with the mutex held.
+static void run_next_tick(rmw_zp_timer_wheel_t* wheel, uint64_t now_us) {
+  const uint64_t tick = wheel->next_tick++;
+
+  // Detach the whole slot first, so that timers re-armed a full turn later do not get visited
+  // twice.
+  rmw_zp_timer_t* timer = wheel->slots[tick & SLOT_MASK];
+  wheel->slots[tick & SLOT_MASK] = NULL;
+
+  while (timer != NULL) {
+    rmw_zp_timer_t* next = timer->next;
+
+    uint64_t expiry_us;
+    if (timer->expiry_tick > tick) {
+      // Expires in a later turn of the wheel.
+      link_timer(wheel, timer);
+    } else if (timer->callback(timer, now_us, &expiry_us)) {
+      timer->expiry_tick = expiry_to_tick(wheel, expiry_us);
+      link_timer(wheel, timer);
+    } else {
+      timer->prev = NULL;
+      timer->next = NULL;
+      timer->is_armed = false;
+      wheel->armed_count--;
+    }
+
+    timer = next;
+  }
+}
+
+// Must be called with the mutex held and at least one timer armed.
+static uint64_t get_next_wakeup_tick(rmw_zp_timer_wheel_t* wheel) {
+  for (uint64_t i = 0; i < RMW_ZP_TIMER_WHEEL_SLOT_COUNT; i++) {
+    if (wheel->slots[(wheel->next_tick + i) & SLOT_MASK] != NULL) {
+      return wheel->next_tick + i;
+    }
+  }
+  return wheel->next_tick + RMW_ZP_TIMER_WHEEL_SLOT_COUNT;
+}
+
+static void* timer_wheel_task(void* data) {
+  rmw_zp_timer_wheel_t* wheel = data;
+
+  z_mutex_lock(z_loan_mut(wheel->mutex));
+
+  while (wheel->is_running) {
+    if (wheel->armed_count == 0) {
+      z_condvar_wait(z_loan_mut(wheel->condition_variable), z_loan_mut(wheel->mutex));
+      continue;
+    }
+
+    uint64_t now_us = rmw_zp_timer_wheel_now_us(wheel);
+    const uint64_t now_tick = now_us / wheel->tick_us;
+
+    // After falling behind by more than a turn, every slot only needs to be visited once.
+    if (now_tick >= wheel->next_tick + RMW_ZP_TIMER_WHEEL_SLOT_COUNT) {
+      wheel->next_tick = now_tick + 1 - RMW_ZP_TIMER_WHEEL_SLOT_COUNT;
+    }
+    while (wheel->next_tick <= now_tick) {
+      run_next_tick(wheel, now_us);
+    }
+
+    if (wheel->armed_count > 0) {
+      const uint64_t wakeup_us = get_next_wakeup_tick(wheel) * wheel->tick_us;
+      now_us = rmw_zp_timer_wheel_now_us(wheel);
+      if (wakeup_us > now_us) {
+        z_condvar_wait_for_us(z_loan_mut(wheel->condition_variable), z_loan_mut(wheel->mutex),
+                              (size_t)(wakeup_us - now_us));
+      }
+    }
+  }
+
+  z_mutex_unlock(z_loan_mut(wheel->mutex));
+
+  return NULL;
+}
+
+void rmw_zp_timer_init(rmw_zp_timer_t* timer, rmw_zp_timer_callback_t callback) {
+  timer->prev = NULL;
+  timer->next = NULL;
+  timer->expiry_tick = 0;
+  timer->is_armed = false;
+  timer->callback = callback;
+}
+
+rmw_ret_t rmw_zp_timer_wheel_init(rmw_zp_timer_wheel_t* wheel, size_t tick_us) {
+  wheel->clock_start = z_clock_now();
+  wheel->tick_us = tick_us > 0 ? tick_us : 1;
+  for (size_t i = 0; i < RMW_ZP_TIMER_WHEEL_SLOT_COUNT; i++) {
+    wheel->slots[i] = NULL;
+  }
+  wheel->next_tick = 0;
+  wheel->armed_count = 0;
+  wheel->is_running = true;
+
+  if (z_mutex_init(&wheel->mutex) < 0) {
+    RMW_SET_ERROR_MSG("Failed to initialize zenohpico mutex");
+    goto fail_init_mutex;
+  }
+
+  if (z_condvar_init(&wheel->condition_variable) < 0) {
+    RMW_SET_ERROR_MSG("Failed to initialize zenohpico condition variable");
+    goto fail_init_condition_variable;
+  }
+
+  if (z_task_init(&wheel->task, NULL, timer_wheel_task, wheel) < 0) {
+    RMW_SET_ERROR_MSG("Failed to start timer wheel task");
+    goto fail_init_task;
+  }
+
+  return RMW_RET_OK;
+
+fail_init_task:
+  z_drop(z_move(wheel->condition_variable));
+fail_init_condition_variable:
+  z_drop(z_move(wheel->mutex));
+fail_init_mutex:
+  wheel->is_running = false;
+  return RMW_RET_ERROR;
+}
+
+rmw_ret_t rmw_zp_timer_wheel_stop(rmw_zp_timer_wheel_t* wheel) {
+  z_mutex_lock(z_loan_mut(wheel->mutex));
+  const bool was_running = wheel->is_running;
+  wheel->is_running = false;
+  z_condvar_signal(z_loan_mut(wheel->condition_variable));
+  z_mutex_unlock(z_loan_mut(wheel->mutex));
+
+  if (was_running && z_task_join(z_move(wheel->task)) < 0) {
+    RMW_SET_ERROR_MSG("Failed to join timer wheel task");
+    return RMW_RET_ERROR;
+  }
+
+  return RMW_RET_OK;
+}
+
+rmw_ret_t rmw_zp_timer_wheel_fini(rmw_zp_timer_wheel_t* wheel) {
+  rmw_ret_t ret = RMW_RET_OK;
+
+  if (z_drop(z_move(wheel->condition_variable)) < 0) {
+    RMW_SET_ERROR_MSG("Failed to drop zenohpico condition variable");
+    ret = RMW_RET_ERROR;
+  }
+
+  if (z_drop(z_move(wheel->mutex)) < 0) {
+    RMW_SET_ERROR_MSG("Failed to drop zenohpico mutex");
+    ret = RMW_RET_ERROR;
+  }
+
+  return ret;
+}
+
+uint64_t rmw_zp_timer_wheel_now_us(rmw_zp_timer_wheel_t* wheel) {
+  return (uint64_t)z_clock_elapsed_us(&wheel->clock_start);
+}
+
+void rmw_zp_timer_wheel_arm(rmw_zp_timer_wheel_t* wheel, rmw_zp_timer_t* timer,
+                            uint64_t expiry_us) {
+  z_mutex_lock(z_loan_mut(wheel->mutex));
+
+  if (timer->is_armed) {
+    unlink_timer(wheel, timer);
+  } else {
+    if (wheel->armed_count == 0) {
+      // Skip the ticks the task slept through while nothing was armed.
+      wheel->next_tick = rmw_zp_timer_wheel_now_us(wheel) / wheel->tick_us;
+    }
+    timer->is_armed = true;
+    wheel->armed_count++;
+  }
+
+  timer->expiry_tick = expiry_to_tick(wheel, expiry_us);
+  link_timer(wheel, timer);
+
+  // The task may be sleeping until a later tick, or until a timer gets armed.
+  z_condvar_signal(z_loan_mut(wheel->condition_variable));
+
+  z_mutex_unlock(z_loan_mut(wheel->mutex));
+}
+
+void rmw_zp_timer_wheel_disarm(rmw_zp_timer_wheel_t* wheel, rmw_zp_timer_t* timer) {
+  z_mutex_lock(z_loan_mut(wheel->mutex));
+
+  if (timer->is_armed) {
+    unlink_timer(wheel, timer);
+    timer->is_armed = false;
+    wheel->armed_count--;
+  }
+
+  z_mutex_unlock(z_loan_mut(wheel->mutex));
+}
\ No newline at end of file
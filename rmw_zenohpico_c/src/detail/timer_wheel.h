@@ -0,0 +1,70 @@
+#ifndef RMW_ZENOHPICO_DETAIL__TIMER_WHEEL_H_
+#define RMW_ZENOHPICO_DETAIL__TIMER_WHEEL_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rmw/ret_types.h"
+#include "zenoh-pico.h"
+
+// Number of slots of a timer wheel, must be a power of two. Timers that expire more than a full
+// turn of the wheel away stay in their slot, and are skipped until their turn comes.
+#define RMW_ZP_TIMER_WHEEL_SLOT_COUNT 256
+
+typedef struct rmw_zp_timer_s rmw_zp_timer_t;
+
+// Called by the task of the wheel, with the mutex of the wheel held, when a timer expires. Returns
+// true and sets `expiry_us` to re-arm the timer, or false to disarm it. It must not call any of the
+// rmw_zp_timer_wheel_* functions.
+typedef bool (*rmw_zp_timer_callback_t)(rmw_zp_timer_t* timer, uint64_t now_us,
+                                        uint64_t* expiry_us);
+
+struct rmw_zp_timer_s {
+  // Guarded by the mutex of the wheel the timer is armed in.
+  rmw_zp_timer_t* prev;
+  rmw_zp_timer_t* next;
+  uint64_t expiry_tick;
+  bool is_armed;
+
+  rmw_zp_timer_callback_t callback;
+};
+
+// Hashed timer wheel shared by all the entities of a context and driven by a single task. Arming
+// and disarming a timer is O(1). While timers are armed the task wakes up at the next tick that
+// has timers in its slot, otherwise it sleeps until one is armed.
+typedef struct {
+  z_owned_mutex_t mutex;
+  z_owned_condvar_t condition_variable;
+  z_owned_task_t task;
+  z_clock_t clock_start;
+  size_t tick_us;
+
+  // Guarded by mutex.
+  rmw_zp_timer_t* slots[RMW_ZP_TIMER_WHEEL_SLOT_COUNT];
+  uint64_t next_tick;
+  size_t armed_count;
+  bool is_running;
+} rmw_zp_timer_wheel_t;
+
+void rmw_zp_timer_init(rmw_zp_timer_t* timer, rmw_zp_timer_callback_t callback);
+
+// Initialize the wheel and start its task. Timers expire up to `tick_us` late.
+rmw_ret_t rmw_zp_timer_wheel_init(rmw_zp_timer_wheel_t* wheel, size_t tick_us);
+
+// Stop the task. Timers can still be disarmed afterwards, but none of them expires anymore.
+rmw_ret_t rmw_zp_timer_wheel_stop(rmw_zp_timer_wheel_t* wheel);
+
+// Must be called after rmw_zp_timer_wheel_stop, once no timer is armed anymore.
+rmw_ret_t rmw_zp_timer_wheel_fini(rmw_zp_timer_wheel_t* wheel);
+
+// Microseconds elapsed since the wheel was initialized, the time base of timer expiries.
+uint64_t rmw_zp_timer_wheel_now_us(rmw_zp_timer_wheel_t* wheel);
+
+// Arm the timer to expire at `expiry_us`, moving it if it is already armed.
+void rmw_zp_timer_wheel_arm(rmw_zp_timer_wheel_t* wheel, rmw_zp_timer_t* timer,
+                            uint64_t expiry_us);
+
+void rmw_zp_timer_wheel_disarm(rmw_zp_timer_wheel_t* wheel, rmw_zp_timer_t* timer);
+
+#endif
\ No newline at end of file
@@ -1,9 +1,11 @@
 #include "./type_support.h"
 
 #include "./identifiers.h"
+#include "./introspection.h"
 #include "rcutils/snprintf.h"
 #include "rmw/error_handling.h"
 #include "rmw/macros.h"
+#include "rosidl_typesupport_introspection_c/identifier.h"
 #include "zenoh-pico.h"
 
 #define CDR_HEADER_SIZE 4
@@ -126,6 +128,16 @@ rmw_ret_t rmw_zp_message_type_support_init(
 
   type_support->type_hash = message_type_support->get_type_hash_func(message_type_support);
 
+  // The introspection type support is optional, it is only needed for loaned messages.
+  const rosidl_message_type_support_t *introspection_type_support = get_message_typesupport_handle(
+      message_type_supports, rosidl_typesupport_introspection_c__identifier);
+  if (introspection_type_support != NULL) {
+    type_support->members = introspection_type_support->data;
+  } else {
+    rcutils_reset_error();
+    type_support->members = NULL;
+  }
+
   return RMW_RET_OK;
 }
 
@@ -234,8 +246,7 @@ rmw_ret_t rmw_zp_service_type_support_serialize_response(
 }
 
 // Deserialize
-static rmw_ret_t deserialize_message(const message_type_support_callbacks_t *type_support_callbacks,
-                                     const uint8_t *buf, size_t buf_size, void *ros_message) {
+static rmw_ret_t init_deserialization_buffer(const uint8_t *buf, size_t buf_size, ucdrBuffer *ub) {
   if (buf_size < CDR_HEADER_SIZE) {
     RMW_SET_ERROR_MSG_WITH_FORMAT_STRING(
         "Cannot deserialize buffer of size: %zu. Must contain at least a 4-byte header", buf_size);
@@ -250,9 +261,19 @@ static rmw_ret_t deserialize_message(const message_type_support_callbacks_t *typ
   }
   // TODO(bjsowa): What do the rest of the bits in the CDR header mean? Do we care?
 
-  ucdrBuffer ub;
-  ucdr_init_buffer_origin_offset_endian(&ub, (uint8_t *)buf, buf_size, CDR_HEADER_SIZE,
+  ucdr_init_buffer_origin_offset_endian(ub, (uint8_t *)buf, buf_size, CDR_HEADER_SIZE,
                                         CDR_HEADER_SIZE, endianness);
+
+  return RMW_RET_OK;
+}
+
+static rmw_ret_t deserialize_message(const message_type_support_callbacks_t *type_support_callbacks,
+                                     const uint8_t *buf, size_t buf_size, void *ros_message) {
+  ucdrBuffer ub;
+  if (init_deserialization_buffer(buf, buf_size, &ub) != RMW_RET_OK) {
+    return RMW_RET_ERROR;
+  }
+
   if (!type_support_callbacks->cdr_deserialize(&ub, ros_message)) {
     RMW_SET_ERROR_MSG("Type support failed to deserialize the message");
     return RMW_RET_ERROR;
@@ -267,6 +288,22 @@ rmw_ret_t rmw_zp_message_type_support_deserialize(rmw_zp_message_type_support_t
   return deserialize_message(type_support->callbacks, buf, buf_size, ros_message);
 }
 
+rmw_ret_t rmw_zp_message_type_support_deserialize_with_introspection(
+    rmw_zp_message_type_support_t *type_support, const uint8_t *buf, size_t buf_size,
+    void *ros_message) {
+  ucdrBuffer ub;
+  if (init_deserialization_buffer(buf, buf_size, &ub) != RMW_RET_OK) {
+    return RMW_RET_ERROR;
+  }
+
+  if (!rmw_zp_introspection_deserialize(type_support->members, &ub, ros_message)) {
+    RMW_SET_ERROR_MSG("Failed to deserialize the message with the introspection type support");
+    return RMW_RET_ERROR;
+  }
+
+  return RMW_RET_OK;
+}
+
 rmw_ret_t rmw_zp_service_type_support_deserialize_request(
     rmw_zp_service_type_support_t *type_support, const uint8_t *buf, size_t buf_size,
     void *ros_request) {
@@ -6,6 +6,7 @@
 #include "rcutils/allocator.h"
 #include "rmw/ret_types.h"
 #include "rosidl_typesupport_microxrcedds_c/message_type_support.h"
+#include "rosidl_typesupport_introspection_c/message_introspection.h"
 #include "rosidl_typesupport_microxrcedds_c/service_type_support.h"
 #include "ucdr/microcdr.h"
 
@@ -13,6 +14,9 @@ typedef struct {
   const char *type_name;
   const rosidl_type_hash_t *type_hash;
   const message_type_support_callbacks_t *callbacks;
+  // Introspection members used to allocate and initialize messages in the middleware (loans).
+  // NULL if the introspection type support of the message is not available.
+  const rosidl_typesupport_introspection_c__MessageMembers *members;
 } rmw_zp_message_type_support_t;
 
 typedef struct {
@@ -74,6 +78,12 @@ rmw_ret_t rmw_zp_message_type_support_deserialize(rmw_zp_message_type_support_t
                                                   const uint8_t *buf, size_t buf_size,
                                                   void *ros_message);
 
+// Deserialize into a message that is reused between takes, growing its sequences and strings as
+// needed. Requires the introspection type support, see rmw_zp_introspection_can_deserialize.
+rmw_ret_t rmw_zp_message_type_support_deserialize_with_introspection(
+    rmw_zp_message_type_support_t *type_support, const uint8_t *buf, size_t buf_size,
+    void *ros_message);
+
 rmw_ret_t rmw_zp_service_type_support_deserialize_request(
     rmw_zp_service_type_support_t *type_support, const uint8_t *buf, size_t buf_size,
     void *ros_request);
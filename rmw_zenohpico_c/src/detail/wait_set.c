@@ -1,9 +1,35 @@
 #include "./wait_set.h"
 
+#if RMW_ZP_HAVE_EVENT_FD
+#include <stdint.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+#include "./macros.h"
 #include "rmw/error_handling.h"
 
-rmw_ret_t rmw_zp_wait_set_init(rmw_zp_wait_set_t* wait_set) {
-  wait_set->triggered = false;
+rmw_ret_t rmw_zp_wait_set_init(rmw_zp_wait_set_t* wait_set, z_owned_mutex_t* attachment_mutex) {
+  wait_set->ready_list = NULL;
+#if RMW_ZP_HAVE_ATOMICS
+  atomic_init(&wait_set->has_ready, false);
+#endif
+#if RMW_ZP_HAVE_EVENT_FD
+  wait_set->event_fd = -1;
+  wait_set->event_fd_is_set = false;
+#endif
+  wait_set->spin_period_us = 0;
+  wait_set->spin_wakeup_count = 0;
+  wait_set->block_wakeup_count = 0;
+  wait_set->attachments_changed = false;
+  wait_set->entities = NULL;
+  wait_set->attachments = NULL;
+  wait_set->ready_attachments = NULL;
+  wait_set->attachment_capacity = 0;
+  wait_set->attachment_mutex = attachment_mutex;
+  for (size_t i = 0; i < RMW_ZP_WAITABLE_KIND_COUNT; i++) {
+    wait_set->entity_counts[i] = 0;
+  }
 
   if (z_mutex_init(&wait_set->condition_mutex) < 0) {
     RCUTILS_SET_ERROR_MSG("Failed to initialize zenohpico mutex");
@@ -22,6 +48,22 @@ rmw_ret_t rmw_zp_wait_set_init(rmw_zp_wait_set_t* wait_set) {
 rmw_ret_t rmw_zp_wait_set_fini(rmw_zp_wait_set_t* wait_set) {
   rmw_ret_t ret = RMW_RET_OK;
 
+  z_mutex_lock(z_loan_mut(*wait_set->attachment_mutex));
+  RMW_UNUSED(rmw_zp_wait_set_reset_attachments(wait_set, 0));
+  z_mutex_unlock(z_loan_mut(*wait_set->attachment_mutex));
+
+  rcutils_allocator_t* allocator = &wait_set->context->options.allocator;
+  allocator->deallocate(wait_set->entities, allocator->state);
+  allocator->deallocate(wait_set->attachments, allocator->state);
+  allocator->deallocate(wait_set->ready_attachments, allocator->state);
+
+#if RMW_ZP_HAVE_EVENT_FD
+  if (wait_set->event_fd >= 0 && close(wait_set->event_fd) < 0) {
+    RCUTILS_SET_ERROR_MSG("Failed to close eventfd");
+    ret = RMW_RET_ERROR;
+  }
+#endif
+
   if (z_drop(z_move(wait_set->condition_mutex)) < 0) {
     RCUTILS_SET_ERROR_MSG("Failed to drop zenohpico mutex");
     ret = RMW_RET_ERROR;
@@ -34,3 +76,305 @@ rmw_ret_t rmw_zp_wait_set_fini(rmw_zp_wait_set_t* wait_set) {
 
   return ret;
 }
+
+// Propagate whether the ready list is empty to the flags that are polled without the mutex. Must
+// be called with the condition_mutex of the wait set held, after changing the ready list.
+static void update_has_ready(rmw_zp_wait_set_t* wait_set) {
+  bool has_ready = wait_set->ready_list != NULL;
+
+#if RMW_ZP_HAVE_ATOMICS
+  atomic_store_explicit(&wait_set->has_ready, has_ready, memory_order_release);
+#endif
+
+#if RMW_ZP_HAVE_EVENT_FD
+  if (wait_set->event_fd >= 0 && wait_set->event_fd_is_set != has_ready) {
+    uint64_t value = 1;
+    // Writing adds to the counter of the eventfd, reading resets it.
+    ssize_t ret = has_ready ? write(wait_set->event_fd, &value, sizeof(value))
+                            : read(wait_set->event_fd, &value, sizeof(value));
+    if (ret == sizeof(value)) {
+      wait_set->event_fd_is_set = has_ready;
+    }
+  }
+#endif
+}
+
+// Must be called with the condition_mutex of the wait set held.
+static void unlink_attachment(rmw_zp_wait_set_attachment_t* attachment) {
+  rmw_zp_wait_set_t* wait_set = attachment->wait_set;
+
+  attachment->is_attached = false;
+
+  if (attachment->is_ready) {
+    rmw_zp_wait_set_attachment_t** link = &wait_set->ready_list;
+    while (*link != attachment) {
+      link = &(*link)->next_ready;
+    }
+    *link = attachment->next_ready;
+    attachment->is_ready = false;
+    update_has_ready(wait_set);
+  }
+}
+
+// Must be called with the mutex of the entity held.
+static void remove_waitable_attachment(rmw_zp_waitable_t* waitable,
+                                       rmw_zp_wait_set_attachment_t* attachment) {
+  for (size_t i = 0; i < waitable->attachment_count; i++) {
+    if (waitable->attachments[i] == attachment) {
+      for (size_t j = i + 1; j < waitable->attachment_count; j++) {
+        waitable->attachments[j - 1] = waitable->attachments[j];
+      }
+      waitable->attachment_count--;
+      return;
+    }
+  }
+}
+
+// Must be called with the attachment_mutex and the mutex of the entity held.
+static void detach_waitable_attachment(rmw_zp_waitable_t* waitable,
+                                       rmw_zp_wait_set_attachment_t* attachment) {
+  rmw_zp_wait_set_t* wait_set = attachment->wait_set;
+
+  z_mutex_lock(z_loan_mut(wait_set->condition_mutex));
+  unlink_attachment(attachment);
+  wait_set->attachments_changed = true;
+  // Wake up a thread blocked in rmw_wait() on the wait set, which no longer hears from the entity.
+  z_condvar_signal(z_loan_mut(wait_set->condition_variable));
+  z_mutex_unlock(z_loan_mut(wait_set->condition_mutex));
+
+  remove_waitable_attachment(waitable, attachment);
+}
+
+// Detach an entity from the wait set side. Must be called with the attachment_mutex held, which
+// keeps is_attached from changing and an attached entity from being destroyed.
+static void detach_attachment(rmw_zp_wait_set_attachment_t* attachment) {
+  rmw_zp_wait_set_t* wait_set = attachment->wait_set;
+
+  if (!attachment->is_attached) {
+    // Never attached, or already detached by the entity.
+    return;
+  }
+
+  z_mutex_lock(z_loan_mut(*attachment->entity_mutex));
+
+  z_mutex_lock(z_loan_mut(wait_set->condition_mutex));
+  unlink_attachment(attachment);
+  z_mutex_unlock(z_loan_mut(wait_set->condition_mutex));
+
+  remove_waitable_attachment(attachment->waitable, attachment);
+
+  z_mutex_unlock(z_loan_mut(*attachment->entity_mutex));
+}
+
+rmw_ret_t rmw_zp_wait_set_reset_attachments(rmw_zp_wait_set_t* wait_set, size_t count) {
+  size_t attachment_count = 0;
+  for (size_t i = 0; i < RMW_ZP_WAITABLE_KIND_COUNT; i++) {
+    attachment_count += wait_set->entity_counts[i];
+    wait_set->entity_counts[i] = 0;
+  }
+
+  for (size_t i = 0; i < attachment_count; i++) {
+    detach_attachment(&wait_set->attachments[i]);
+  }
+
+  z_mutex_lock(z_loan_mut(wait_set->condition_mutex));
+  wait_set->attachments_changed = false;
+  z_mutex_unlock(z_loan_mut(wait_set->condition_mutex));
+
+  if (count <= wait_set->attachment_capacity) {
+    return RMW_RET_OK;
+  }
+
+  rcutils_allocator_t* allocator = &wait_set->context->options.allocator;
+
+  void** entities =
+      allocator->reallocate(wait_set->entities, count * sizeof(void*), allocator->state);
+  if (entities == NULL) {
+    goto fail_allocate;
+  }
+  wait_set->entities = entities;
+
+  rmw_zp_wait_set_attachment_t* attachments = allocator->reallocate(
+      wait_set->attachments, count * sizeof(rmw_zp_wait_set_attachment_t), allocator->state);
+  if (attachments == NULL) {
+    goto fail_allocate;
+  }
+  wait_set->attachments = attachments;
+
+  rmw_zp_wait_set_attachment_t** ready_attachments =
+      allocator->reallocate(wait_set->ready_attachments,
+                            count * sizeof(rmw_zp_wait_set_attachment_t*), allocator->state);
+  if (ready_attachments == NULL) {
+    goto fail_allocate;
+  }
+  wait_set->ready_attachments = ready_attachments;
+
+  wait_set->attachment_capacity = count;
+
+  return RMW_RET_OK;
+
+fail_allocate:
+  RMW_SET_ERROR_MSG("Failed to allocate wait set attachments");
+  return RMW_RET_BAD_ALLOC;
+}
+
+void rmw_zp_wait_set_attachment_init(rmw_zp_wait_set_attachment_t* attachment,
+                                     rmw_zp_wait_set_t* wait_set, rmw_zp_waitable_kind_t kind,
+                                     size_t index) {
+  attachment->wait_set = wait_set;
+  attachment->kind = kind;
+  attachment->index = index;
+  attachment->entity_mutex = NULL;
+  attachment->waitable = NULL;
+  attachment->is_attached = false;
+  attachment->is_ready = false;
+  attachment->next_ready = NULL;
+}
+
+size_t rmw_zp_wait_set_take_ready_list(rmw_zp_wait_set_t* wait_set) {
+  size_t count = 0;
+
+  for (rmw_zp_wait_set_attachment_t* attachment = wait_set->ready_list; attachment != NULL;
+       attachment = attachment->next_ready) {
+    attachment->is_ready = false;
+    wait_set->ready_attachments[count++] = attachment;
+  }
+
+  wait_set->ready_list = NULL;
+  update_has_ready(wait_set);
+
+  return count;
+}
+
+rmw_ret_t rmw_zp_wait_set_get_event_fd(rmw_zp_wait_set_t* wait_set, int* fd) {
+#if RMW_ZP_HAVE_EVENT_FD
+  rmw_ret_t ret = RMW_RET_OK;
+
+  z_mutex_lock(z_loan_mut(wait_set->condition_mutex));
+
+  if (wait_set->event_fd < 0) {
+    wait_set->event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wait_set->event_fd < 0) {
+      RMW_SET_ERROR_MSG("Failed to create eventfd");
+      ret = RMW_RET_ERROR;
+    } else {
+      update_has_ready(wait_set);
+    }
+  }
+  *fd = wait_set->event_fd;
+
+  z_mutex_unlock(z_loan_mut(wait_set->condition_mutex));
+
+  return ret;
+#else
+  RCUTILS_UNUSED(wait_set);
+  RCUTILS_UNUSED(fd);
+  RMW_SET_ERROR_MSG("eventfd is not supported on this platform");
+  return RMW_RET_UNSUPPORTED;
+#endif
+}
+
+bool rmw_zp_wait_set_spin(rmw_zp_wait_set_t* wait_set, z_clock_t* clock_start,
+                          size_t spin_period_us) {
+  do {
+#if RMW_ZP_HAVE_ATOMICS
+    if (atomic_load_explicit(&wait_set->has_ready, memory_order_acquire)) {
+      return true;
+    }
+#else
+    z_mutex_lock(z_loan_mut(wait_set->condition_mutex));
+    bool has_ready = wait_set->ready_list != NULL;
+    z_mutex_unlock(z_loan_mut(wait_set->condition_mutex));
+    if (has_ready) {
+      return true;
+    }
+#endif
+  } while (z_clock_elapsed_us(clock_start) < spin_period_us);
+
+  return false;
+}
+
+// Must be called with the condition_mutex of the wait set held.
+static void push_ready_attachment(rmw_zp_wait_set_attachment_t* attachment) {
+  rmw_zp_wait_set_t* wait_set = attachment->wait_set;
+
+  if (!attachment->is_ready) {
+    attachment->is_ready = true;
+    attachment->next_ready = wait_set->ready_list;
+    wait_set->ready_list = attachment;
+    if (attachment->next_ready == NULL) {
+      update_has_ready(wait_set);
+    }
+  }
+  z_condvar_signal(z_loan_mut(wait_set->condition_variable));
+}
+
+void rmw_zp_wait_set_restore_ready_list(rmw_zp_wait_set_t* wait_set, size_t count) {
+  z_mutex_lock(z_loan_mut(wait_set->condition_mutex));
+
+  for (size_t i = 0; i < count; i++) {
+    rmw_zp_wait_set_attachment_t* attachment = wait_set->ready_attachments[i];
+    // Skip the ones that were detached in the meantime.
+    if (attachment->is_attached) {
+      push_ready_attachment(attachment);
+    }
+  }
+
+  z_mutex_unlock(z_loan_mut(wait_set->condition_mutex));
+}
+
+void rmw_zp_waitable_init(rmw_zp_waitable_t* waitable) { waitable->attachment_count = 0; }
+
+rmw_ret_t rmw_zp_waitable_attach(rmw_zp_waitable_t* waitable, z_owned_mutex_t* entity_mutex,
+                                 rmw_zp_wait_set_attachment_t* attachment, bool is_ready) {
+  if (waitable->attachment_count == RMW_ZP_WAITABLE_MAX_WAIT_SETS) {
+    // Taking the entity away from another wait set would leave that one without wake-ups.
+    RMW_SET_ERROR_MSG("entity is already waited on by too many wait sets");
+    return RMW_RET_ERROR;
+  }
+
+  rmw_zp_wait_set_t* wait_set = attachment->wait_set;
+
+  attachment->entity_mutex = entity_mutex;
+  attachment->waitable = waitable;
+  waitable->attachments[waitable->attachment_count++] = attachment;
+
+  z_mutex_lock(z_loan_mut(wait_set->condition_mutex));
+  attachment->is_attached = true;
+  if (is_ready) {
+    push_ready_attachment(attachment);
+  }
+  z_mutex_unlock(z_loan_mut(wait_set->condition_mutex));
+
+  return RMW_RET_OK;
+}
+
+void rmw_zp_waitable_notify(rmw_zp_waitable_t* waitable) {
+  for (size_t i = 0; i < waitable->attachment_count; i++) {
+    rmw_zp_wait_set_t* wait_set = waitable->attachments[i]->wait_set;
+
+    z_mutex_lock(z_loan_mut(wait_set->condition_mutex));
+    push_ready_attachment(waitable->attachments[i]);
+    z_mutex_unlock(z_loan_mut(wait_set->condition_mutex));
+  }
+}
+
+void rmw_zp_waitable_fini(rmw_zp_waitable_t* waitable, z_owned_mutex_t* entity_mutex) {
+  // All the wait sets of the entity belong to its context, and share the same attachment_mutex.
+  z_mutex_lock(z_loan_mut(*entity_mutex));
+  z_owned_mutex_t* attachment_mutex =
+      waitable->attachment_count > 0 ? waitable->attachments[0]->wait_set->attachment_mutex : NULL;
+  z_mutex_unlock(z_loan_mut(*entity_mutex));
+
+  if (attachment_mutex == NULL) {
+    return;
+  }
+
+  z_mutex_lock(z_loan_mut(*attachment_mutex));
+  z_mutex_lock(z_loan_mut(*entity_mutex));
+  while (waitable->attachment_count > 0) {
+    detach_waitable_attachment(waitable, waitable->attachments[0]);
+  }
+  z_mutex_unlock(z_loan_mut(*entity_mutex));
+  z_mutex_unlock(z_loan_mut(*attachment_mutex));
+}
\ No newline at end of file
@@ -1,45 +1,165 @@
 #ifndef RMW_ZENOHPICO_DETAIL__WAIT_SET_H_
 #define RMW_ZENOHPICO_DETAIL__WAIT_SET_H_
 
+#include <stdbool.h>
 #include <stdint.h>
 
+#include "./atomic.h"
 #include "rmw/init.h"
 #include "zenoh-pico.h"
 
+// On Linux a wait set can also signal readiness through an eventfd, so that applications can
+// poll it together with their own file descriptors.
+#if defined(__linux__)
+#define RMW_ZP_HAVE_EVENT_FD 1
+#else
+#define RMW_ZP_HAVE_EVENT_FD 0
+#endif
+
+typedef enum {
+  RMW_ZP_WAITABLE_GUARD_CONDITION,
+  RMW_ZP_WAITABLE_SUBSCRIPTION,
+  RMW_ZP_WAITABLE_SERVICE,
+  RMW_ZP_WAITABLE_CLIENT,
+  RMW_ZP_WAITABLE_EVENT,
+  RMW_ZP_WAITABLE_KIND_COUNT,
+} rmw_zp_waitable_kind_t;
+
+typedef struct rmw_zp_wait_set_attachment_s rmw_zp_wait_set_attachment_t;
+
+// Number of wait sets an entity can be attached to at the same time, e.g. when several executors
+// wait on it. rmw_wait() fails on a wait set that would be one more.
+#define RMW_ZP_WAITABLE_MAX_WAIT_SETS 4
+
+// Embedded in every entity that can be waited on. Guarded by the mutex of the entity, which is
+// passed to rmw_zp_waitable_attach.
 typedef struct {
-  // The combination of condition_variable, condition_mutex, and triggered are used to make sure
-  // there isn't a race in rmw_wait().  That could happen because of the following sequence:
-  //
-  // 1. Without taking a lock, rmw_wait() checks if any of the entities in the wait_set are ready,
-  //    and if not attachs the condition_variable to it.
-  // 2. It then takes the lock, and sleeps on the condition_variable.
+  rmw_zp_wait_set_attachment_t* attachments[RMW_ZP_WAITABLE_MAX_WAIT_SETS];
+  size_t attachment_count;
+} rmw_zp_waitable_t;
+
+typedef struct {
+  // Entities stay attached to the wait set between calls to rmw_wait() for as long as rmw_wait()
+  // is given the same entities. An entity that becomes ready (new data or a triggered guard
+  // condition) pushes its attachment onto ready_list and signals condition_variable, both under
+  // condition_mutex. rmw_wait() then only looks at the ready entities, instead of checking and
+  // locking every entity before and after sleeping.
   //
-  // However, doing step 1 takes time, and checks in a particular order: guard_conditions, events,
-  // subscriptions, services, clients. The race could happen because a subscription may come in
-  // subscriptions have been checked in the above list (while services and clients are being
-  // checked). In that case, rmw_wait() will unnecessarily go to sleep on the condition_variable,
-  // even though something is ready. This increases the latency.
+  // Checking the ready list and going to sleep happen under condition_mutex, so an entity that
+  // becomes ready in between cannot be missed. This also deals with "spurious" wakeups, where the
+  // condition_variable was woken up even though nothing in this wait_set became ready.
   //
-  // To solve the issue, rmw_wait() still does all of the checking and attaching unlocked. However,
-  // the "notify" method of each entity takes the condition_mutex lock, and in addition to kicking
-  // the condition_variable it sets "triggreed" in this structure to "true". Then after rmw_wait()
-  // has finished attaching, it takes the lock and sets a predicate on the condition_variable so
-  // that it will quit if wait_set_data->triggered is true. Thus, if one of the entities became
-  // ready after we checked, the condition_variable will notice it and not go to sleep.
+  // Attaching an entity to the wait set or detaching it needs both the mutex of the entity and
+  // condition_mutex. They are always locked in that order, with the attachment_mutex of the
+  // context locked before them. An entity only detaches itself under that mutex, so the wait set
+  // can lock the mutex of an entity that is attached to it without it being destroyed meanwhile.
   //
-  // This also deals with "spurious" wakeups, where the condition_variable was woken up even though
-  // nothing in this wait_set became ready.
+  // Entities whose data was not fully taken are put back on the list, so they are reported again
+  // by the next call.
 
   z_owned_condvar_t condition_variable;
   z_owned_mutex_t condition_mutex;
 
-  bool triggered;
+  // Guarded by condition_mutex.
+  rmw_zp_wait_set_attachment_t* ready_list;
+#if RMW_ZP_HAVE_ATOMICS
+  // Whether ready_list is non-empty, so that rmw_wait() can spin on it without taking the mutex.
+  atomic_bool has_ready;
+#endif
+#if RMW_ZP_HAVE_EVENT_FD
+  // An eventfd that is readable while ready_list is non-empty, or -1 until it is requested with
+  // rmw_zp_wait_set_get_event_fd. Guarded by condition_mutex.
+  int event_fd;
+  bool event_fd_is_set;
+#endif
+
+  // Time rmw_wait() polls for ready entities before blocking on condition_variable, and how often
+  // each of them resolved the wait. Guarded by condition_mutex.
+  size_t spin_period_us;
+  size_t spin_wakeup_count;
+  size_t block_wakeup_count;
+
+  // Set when an entity detaches itself before it is destroyed, so that the next rmw_wait()
+  // attaches the entities again even if it is given the same pointers. Guarded by
+  // condition_mutex.
+  bool attachments_changed;
+
+  // The entities rmw_wait() was last given and their attachments, grouped by kind in the order of
+  // rmw_zp_waitable_kind_t and in the order of the arrays passed to rmw_wait(). Only accessed by
+  // rmw_wait().
+  void** entities;
+  rmw_zp_wait_set_attachment_t* attachments;
+  size_t entity_counts[RMW_ZP_WAITABLE_KIND_COUNT];
+
+  // Room for the ready list taken by rmw_wait().
+  rmw_zp_wait_set_attachment_t** ready_attachments;
+
+  size_t attachment_capacity;
+
+  // Shared by all the wait sets of the context.
+  z_owned_mutex_t* attachment_mutex;
 
   rmw_context_t* context;
 } rmw_zp_wait_set_t;
 
-rmw_ret_t rmw_zp_wait_set_init(rmw_zp_wait_set_t* wait_set);
+struct rmw_zp_wait_set_attachment_s {
+  rmw_zp_wait_set_t* wait_set;
+  rmw_zp_waitable_kind_t kind;
+  // Index of the entity in the array of its kind passed to rmw_wait().
+  size_t index;
 
+  z_owned_mutex_t* entity_mutex;
+  rmw_zp_waitable_t* waitable;
+
+  // Guarded by the condition_mutex of the wait set. is_attached is only changed with the
+  // attachment_mutex held too.
+  bool is_attached;
+  bool is_ready;
+  rmw_zp_wait_set_attachment_t* next_ready;
+};
+
+rmw_ret_t rmw_zp_wait_set_init(rmw_zp_wait_set_t* wait_set, z_owned_mutex_t* attachment_mutex);
+
+// Detaches all the entities.
 rmw_ret_t rmw_zp_wait_set_fini(rmw_zp_wait_set_t* wait_set);
 
+// Detach all the entities and make room for `count` of them. The caller then fills entities,
+// entity_counts and the attachments (with rmw_zp_wait_set_attachment_init), and attaches them.
+// Must be called with attachment_mutex held.
+rmw_ret_t rmw_zp_wait_set_reset_attachments(rmw_zp_wait_set_t* wait_set, size_t count);
+
+void rmw_zp_wait_set_attachment_init(rmw_zp_wait_set_attachment_t* attachment,
+                                     rmw_zp_wait_set_t* wait_set, rmw_zp_waitable_kind_t kind,
+                                     size_t index);
+
+// Get the eventfd of the wait set, creating it on first use.
+rmw_ret_t rmw_zp_wait_set_get_event_fd(rmw_zp_wait_set_t* wait_set, int* fd);
+
+// Poll for ready entities until the wait set has been spinning for `spin_period_us` since
+// `clock_start`. Returns whether an entity became ready.
+bool rmw_zp_wait_set_spin(rmw_zp_wait_set_t* wait_set, z_clock_t* clock_start,
+                          size_t spin_period_us);
+
+// Move the ready list to ready_attachments and return its length. Must be called with
+// condition_mutex held.
+size_t rmw_zp_wait_set_take_ready_list(rmw_zp_wait_set_t* wait_set);
+
+// Put back on the ready list the first `count` ready_attachments.
+void rmw_zp_wait_set_restore_ready_list(rmw_zp_wait_set_t* wait_set, size_t count);
+
+void rmw_zp_waitable_init(rmw_zp_waitable_t* waitable);
+
+// Attach the entity to the wait set of `attachment`, in addition to the ones it is attached to.
+// Fails if it is already attached to RMW_ZP_WAITABLE_MAX_WAIT_SETS wait sets. Must be called with
+// the attachment_mutex of the wait set and the mutex of the entity held.
+rmw_ret_t rmw_zp_waitable_attach(rmw_zp_waitable_t* waitable, z_owned_mutex_t* entity_mutex,
+                                 rmw_zp_wait_set_attachment_t* attachment, bool is_ready);
+
+// Wake up all the wait sets the entity is attached to. Must be called with the mutex of the entity
+// held.
+void rmw_zp_waitable_notify(rmw_zp_waitable_t* waitable);
+
+// Detach the entity from all wait sets before it is destroyed. Locks the mutex of the entity.
+void rmw_zp_waitable_fini(rmw_zp_waitable_t* waitable, z_owned_mutex_t* entity_mutex);
+
 #endif
\ No newline at end of file
@@ -10,6 +10,7 @@
 #include "rmw/error_handling.h"
 #include "rmw/rmw.h"
 #include "rmw/validate_full_topic_name.h"
+#include "rmw_zenohpico_c/client.h"
 
 rmw_client_t* rmw_create_client(const rmw_node_t* node,
                                 const rosidl_service_type_support_t* type_supports,
@@ -59,7 +60,10 @@ rmw_client_t* rmw_create_client(const rmw_node_t* node,
   RMW_CHECK_FOR_NULL_WITH_MSG(client_data, "failed to allocate memory for client data",
                               goto fail_allocate_client_data);
 
-  if (rmw_zp_client_init(client_data, qos_profile, allocator) != RMW_RET_OK) {
+  const rmw_zp_config_t* config = &node->context->impl->config;
+  if (rmw_zp_client_init(client_data, qos_profile, config->client_query_timeout_ms,
+                         config->client_max_in_flight, config->client_query_target,
+                         config->client_query_consolidation, allocator) != RMW_RET_OK) {
     goto fail_init_client_data;
   }
 
@@ -67,6 +71,12 @@ rmw_client_t* rmw_create_client(const rmw_node_t* node,
 
   client_data->context = node->context;
 
+  if (rmw_zp_attachment_template_init(&client_data->attachment_template, client_data->client_gid,
+                                      node->context->impl->config.attachment_format) !=
+      RMW_RET_OK) {
+    goto fail_init_attachment_template;
+  }
+
   client_data->type_support =
       allocator->zero_allocate(1, sizeof(rmw_zp_service_type_support_t), allocator->state);
   RMW_CHECK_FOR_NULL_WITH_MSG(client_data->type_support,
@@ -125,6 +135,7 @@ fail_allocate_service_name:
 fail_init_type_support:
   allocator->deallocate(client_data->type_support, allocator->state);
 fail_allocate_type_support:
+fail_init_attachment_template:
   rmw_zp_client_fini(client_data, allocator);
 fail_init_client_data:
   allocator->deallocate(client_data, allocator->state);
@@ -156,11 +167,16 @@ rmw_ret_t rmw_destroy_client(rmw_node_t* node, rmw_client_t* client) {
 
   allocator->deallocate(client_data->type_support, allocator->state);
 
-  if (rmw_zp_client_fini(client_data, allocator) != RMW_RET_OK) {
-    ret = RMW_RET_ERROR;
+  // See the comment about the "num_in_flight" class variable in the
+  // rmw_client_data_t class for why we need to do this.
+  if (rmw_zp_client_shutdown(client_data)) {
+    if (rmw_zp_client_fini(client_data, allocator) != RMW_RET_OK) {
+      ret = RMW_RET_ERROR;
+    }
+
+    allocator->deallocate(client_data, allocator->state);
   }
 
-  allocator->deallocate(client_data, allocator->state);
   allocator->deallocate(client, allocator->state);
 
   return ret;
@@ -203,13 +219,43 @@ rmw_ret_t rmw_send_request(const rmw_client_t* client, const void* ros_request,
   rmw_context_impl_t* context_impl = client_data->context->impl;
   rcutils_allocator_t* allocator = &(client_data->context->options.allocator);
 
+  // See the comment about the "num_in_flight" class variable in the
+  // rmw_client_data_t class for why we need to do this. Fail fast rather than piling up queries
+  // that may never be answered.
+  if (!rmw_zp_client_try_increment_queries_in_flight(client_data)) {
+    RMW_SET_ERROR_MSG("too many requests in flight");
+    return RMW_RET_ERROR;
+  }
+
+  rmw_ret_t ret = RMW_RET_ERROR;
+  bool queries_in_flight;
+
+  rmw_zp_client_query_t* query =
+      allocator->zero_allocate(1, sizeof(rmw_zp_client_query_t), allocator->state);
+  if (query == NULL) {
+    RMW_SET_ERROR_MSG("failed to allocate query data");
+    ret = RMW_RET_BAD_ALLOC;
+    goto fail_allocate_query;
+  }
+
+  // Target, consolidation and timeout of the query, from the RMW_ZENOHPICO_CLIENT_QUERY_*
+  // environment variables unless changed for this client.
+  z_get_options_t opts;
+  rmw_zp_client_get_query_options(client_data, &opts);
+
+  query->client = client_data;
+  query->timeout_ms = opts.timeout_ms;
+
   // Serialize request
   size_t serialized_size = rmw_zp_service_type_support_get_request_serialized_size(
       client_data->type_support, ros_request);
 
   uint8_t* request_bytes = allocator->allocate(serialized_size, allocator->state);
-  RMW_CHECK_FOR_NULL_WITH_MSG(request_bytes, "failed allocate request message bytes",
-                              return RMW_RET_BAD_ALLOC);
+  if (request_bytes == NULL) {
+    RMW_SET_ERROR_MSG("failed allocate request message bytes");
+    ret = RMW_RET_BAD_ALLOC;
+    goto fail_allocate_request_bytes;
+  }
 
   if (rmw_zp_service_type_support_serialize_request(client_data->type_support, ros_request,
                                                     request_bytes, serialized_size) != RMW_RET_OK) {
@@ -218,76 +264,59 @@ rmw_ret_t rmw_send_request(const rmw_client_t* client, const void* ros_request,
 
   // Create attachment
   *sequence_id = rmw_zp_client_get_next_sequence_number(client_data);
+  query->sequence_number = *sequence_id;
 
   int64_t source_timestamp;
   if (rmw_zp_get_current_timestamp(&source_timestamp) != RMW_RET_OK) {
     goto fail_get_current_timestamp;
   }
 
-  rmw_zp_attachment_data_t attachment_data = {.sequence_number = *sequence_id,
-                                              .source_timestamp = source_timestamp};
-  memcpy(attachment_data.source_gid, client_data->client_gid, RMW_GID_STORAGE_SIZE);
+  uint8_t attachment_bytes[RMW_ZP_ATTACHMENT_TEMPLATE_MAX_SIZE];
+  rmw_zp_attachment_template_fill(&client_data->attachment_template, *sequence_id, source_timestamp,
+                                  attachment_bytes);
 
   z_owned_bytes_t attachment;
-  if (rmw_zp_attachment_data_serialize_to_zbytes(&attachment_data, &attachment) != RMW_RET_OK) {
-    goto fail_serialize_attachment;
-  }
+  z_bytes_from_static_buf(&attachment, attachment_bytes, client_data->attachment_template.size);
 
-  z_get_options_t opts;
-  z_get_options_default(&opts);
   opts.attachment = z_move(attachment);
 
-  // See the comment about the "num_in_flight" class variable in the
-  // rmw_client_data_t class for why we need to do this.
-  rmw_zp_client_increment_queries_in_flight(client_data);
-
-  opts.target = Z_QUERY_TARGET_ALL_COMPLETE;
-  // The default timeout for a z_get query is 10 seconds and if a response is
-  // not received within this window, the queryable will return an invalid
-  // reply. However, it is common for actions, which are implemented using
-  // services, to take an extended duration to complete. Hence, we set the
-  // timeout_ms to the largest supported value to account for most realistic
-  // scenarios.
-  opts.timeout_ms = UINT32_MAX;
-  // Latest consolidation guarantees unicity of replies for the same key
-  // expression, which optimizes bandwidth. The default is "None", which imples
-  // replies may come in any order and any number.
-  opts.consolidation = z_query_consolidation_latest();
-
   z_owned_bytes_t payload;
   z_bytes_from_static_buf(&payload, request_bytes, serialized_size);
   opts.payload = z_move(payload);
 
   z_owned_closure_reply_t callback;
-  z_closure(&callback, rmw_zp_client_data_handler, rmw_zp_client_data_dropper, client_data);
+  z_closure(&callback, rmw_zp_client_data_handler, rmw_zp_client_data_dropper, query);
 
+  query->send_time = z_clock_now();
+
+  // From here on, the query data is owned by the closure, which releases it when dropped.
   if (z_get(z_loan(context_impl->session), z_loan(client_data->keyexpr), "", z_move(callback),
             &opts) < 0) {
     RMW_SET_ERROR_MSG("Failed to send zenoh query");
-    goto fail_send_zenoh_query;
+    z_drop(opts.attachment);
+    allocator->deallocate(request_bytes, allocator->state);
+    return RMW_RET_ERROR;
   }
 
   allocator->deallocate(request_bytes, allocator->state);
 
   return RMW_RET_OK;
 
-fail_send_zenoh_query:
-  z_drop(opts.attachment);
-fail_serialize_attachment:
 fail_get_current_timestamp:
 fail_serialize_ros_request:
   allocator->deallocate(request_bytes, allocator->state);
-  return RMW_RET_ERROR;
+fail_allocate_request_bytes:
+  allocator->deallocate(query, allocator->state);
+fail_allocate_query:
+  rmw_zp_client_decrement_queries_in_flight(client_data, &queries_in_flight);
+  return ret;
 }
 
 rmw_ret_t rmw_take_response(const rmw_client_t* client, rmw_service_info_t* request_header,
                             void* ros_response, bool* taken) {
-  RCUTILS_UNUSED(request_header);
-
-  *taken = false;
-
   RMW_CHECK_ARGUMENT_FOR_NULL(client, RMW_RET_INVALID_ARGUMENT);
   RMW_CHECK_ARGUMENT_FOR_NULL(client->data, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(request_header, RMW_RET_INVALID_ARGUMENT);
   RMW_CHECK_ARGUMENT_FOR_NULL(ros_response, RMW_RET_INVALID_ARGUMENT);
   RMW_CHECK_ARGUMENT_FOR_NULL(taken, RMW_RET_INVALID_ARGUMENT);
   RMW_CHECK_TYPE_IDENTIFIERS_MATCH(client, client->implementation_identifier, rmw_zp_identifier,
@@ -295,8 +324,12 @@ rmw_ret_t rmw_take_response(const rmw_client_t* client, rmw_service_info_t* requ
   RMW_CHECK_FOR_NULL_WITH_MSG(client->service_name, "client has no service name",
                               RMW_RET_INVALID_ARGUMENT);
 
+  *taken = false;
+
   rmw_zp_client_t* client_data = client->data;
 
+  // Replies are matched to the request they answer when they are received, so only the first
+  // reply to each request sent by this client gets here.
   rmw_zp_message_t reply_data;
   if (rmw_zp_client_pop_next_reply(client_data, &reply_data) != RMW_RET_OK) {
     // This tells rcl that the check for a new message was done, but no messages
@@ -304,12 +337,21 @@ rmw_ret_t rmw_take_response(const rmw_client_t* client, rmw_service_info_t* requ
     return RMW_RET_OK;
   }
 
-  const uint8_t* payload = z_slice_data(z_loan(reply_data.payload));
-  const size_t payload_len = z_slice_len(z_loan(reply_data.payload));
+  rcutils_allocator_t* allocator = &client_data->context->options.allocator;
 
-  if (rmw_zp_service_type_support_deserialize_response(client_data->type_support, payload,
-                                                       payload_len, ros_response) != RMW_RET_OK) {
-    z_drop(z_move(reply_data.payload));
+  rmw_zp_payload_view_t payload;
+  if (rmw_zp_message_get_payload_view(&reply_data, allocator, &payload) != RMW_RET_OK) {
+    rmw_zp_message_fini(&reply_data);
+    return RMW_RET_ERROR;
+  }
+
+  rmw_ret_t ret = rmw_zp_service_type_support_deserialize_response(
+      client_data->type_support, payload.data, payload.len, ros_response);
+
+  rmw_zp_payload_view_fini(&payload, allocator);
+
+  if (ret != RMW_RET_OK) {
+    rmw_zp_message_fini(&reply_data);
     return RMW_RET_ERROR;
   }
 
@@ -319,7 +361,7 @@ rmw_ret_t rmw_take_response(const rmw_client_t* client, rmw_service_info_t* requ
   memcpy(request_header->request_id.writer_guid, reply_data.attachment_data.source_gid,
          RMW_GID_STORAGE_SIZE);
 
-  z_drop(z_move(reply_data.payload));
+  rmw_zp_message_fini(&reply_data);
   *taken = true;
 
   return RMW_RET_OK;
@@ -340,8 +382,117 @@ rmw_ret_t rmw_get_gid_for_client(const rmw_client_t* client, rmw_gid_t* gid) {
 rmw_ret_t rmw_client_set_on_new_response_callback(rmw_client_t* client,
                                                   rmw_event_callback_t callback,
                                                   const void* user_data) {
-  RCUTILS_UNUSED(client);
-  RCUTILS_UNUSED(callback);
-  RCUTILS_UNUSED(user_data);
-  return RMW_RET_UNSUPPORTED;
+  RMW_CHECK_ARGUMENT_FOR_NULL(client, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(client, client->implementation_identifier, rmw_zp_identifier,
+                                   return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+
+  rmw_zp_client_t* client_data = client->data;
+  RMW_CHECK_ARGUMENT_FOR_NULL(client_data, RMW_RET_INVALID_ARGUMENT);
+
+  rmw_zp_client_set_data_callback(client_data, callback, user_data);
+
+  return RMW_RET_OK;
+}
+
+rmw_ret_t rmw_zenohpico_client_set_query_timeout(rmw_client_t* client, size_t timeout_ms) {
+  RMW_CHECK_ARGUMENT_FOR_NULL(client, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(client, client->implementation_identifier, rmw_zp_identifier,
+                                   return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+
+  rmw_zp_client_t* client_data = client->data;
+  RMW_CHECK_ARGUMENT_FOR_NULL(client_data, RMW_RET_INVALID_ARGUMENT);
+
+  rmw_zp_client_set_query_timeout(client_data, timeout_ms);
+
+  return RMW_RET_OK;
+}
+
+rmw_ret_t rmw_zenohpico_client_set_query_target(rmw_client_t* client,
+                                                rmw_zenohpico_query_target_t target) {
+  RMW_CHECK_ARGUMENT_FOR_NULL(client, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(client, client->implementation_identifier, rmw_zp_identifier,
+                                   return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+
+  rmw_zp_client_t* client_data = client->data;
+  RMW_CHECK_ARGUMENT_FOR_NULL(client_data, RMW_RET_INVALID_ARGUMENT);
+
+  z_query_target_t query_target;
+  switch (target) {
+    case RMW_ZENOHPICO_QUERY_TARGET_BEST_MATCHING:
+      query_target = Z_QUERY_TARGET_BEST_MATCHING;
+      break;
+    case RMW_ZENOHPICO_QUERY_TARGET_ALL:
+      query_target = Z_QUERY_TARGET_ALL;
+      break;
+    case RMW_ZENOHPICO_QUERY_TARGET_ALL_COMPLETE:
+      query_target = Z_QUERY_TARGET_ALL_COMPLETE;
+      break;
+    default:
+      RMW_SET_ERROR_MSG("invalid query target");
+      return RMW_RET_INVALID_ARGUMENT;
+  }
+
+  rmw_zp_client_set_query_target(client_data, query_target);
+
+  return RMW_RET_OK;
+}
+
+rmw_ret_t rmw_zenohpico_client_set_query_consolidation(
+    rmw_client_t* client, rmw_zenohpico_query_consolidation_t consolidation) {
+  RMW_CHECK_ARGUMENT_FOR_NULL(client, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(client, client->implementation_identifier, rmw_zp_identifier,
+                                   return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+
+  rmw_zp_client_t* client_data = client->data;
+  RMW_CHECK_ARGUMENT_FOR_NULL(client_data, RMW_RET_INVALID_ARGUMENT);
+
+  z_consolidation_mode_t query_consolidation;
+  switch (consolidation) {
+    case RMW_ZENOHPICO_QUERY_CONSOLIDATION_AUTO:
+      query_consolidation = Z_CONSOLIDATION_MODE_AUTO;
+      break;
+    case RMW_ZENOHPICO_QUERY_CONSOLIDATION_NONE:
+      query_consolidation = Z_CONSOLIDATION_MODE_NONE;
+      break;
+    case RMW_ZENOHPICO_QUERY_CONSOLIDATION_MONOTONIC:
+      query_consolidation = Z_CONSOLIDATION_MODE_MONOTONIC;
+      break;
+    case RMW_ZENOHPICO_QUERY_CONSOLIDATION_LATEST:
+      query_consolidation = Z_CONSOLIDATION_MODE_LATEST;
+      break;
+    default:
+      RMW_SET_ERROR_MSG("invalid query consolidation");
+      return RMW_RET_INVALID_ARGUMENT;
+  }
+
+  rmw_zp_client_set_query_consolidation(client_data, query_consolidation);
+
+  return RMW_RET_OK;
+}
+
+rmw_ret_t rmw_zenohpico_client_get_statistics(const rmw_client_t* client,
+                                              rmw_zenohpico_client_statistics_t* statistics) {
+  RMW_CHECK_ARGUMENT_FOR_NULL(client, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(client, client->implementation_identifier, rmw_zp_identifier,
+                                   return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+  RMW_CHECK_ARGUMENT_FOR_NULL(statistics, RMW_RET_INVALID_ARGUMENT);
+
+  rmw_zp_client_t* client_data = client->data;
+  RMW_CHECK_ARGUMENT_FOR_NULL(client_data, RMW_RET_INVALID_ARGUMENT);
+
+  z_mutex_lock(z_loan_mut(client_data->condition_mutex));
+  statistics->in_flight_request_count = rmw_zp_client_get_queries_in_flight(client_data);
+  statistics->rejected_request_count = client_data->rejected_request_count;
+  statistics->timed_out_request_count = client_data->timed_out_request_count;
+  statistics->error_reply_count = client_data->error_reply_count;
+  statistics->unanswered_request_count = client_data->unanswered_request_count;
+  statistics->response_count = client_data->response_count;
+  statistics->unexpected_reply_count = client_data->unexpected_reply_count;
+  statistics->round_trip_time_last_us = client_data->round_trip_time_last_us;
+  statistics->round_trip_time_min_us = client_data->round_trip_time_min_us;
+  statistics->round_trip_time_max_us = client_data->round_trip_time_max_us;
+  statistics->round_trip_time_total_us = client_data->round_trip_time_total_us;
+  z_mutex_unlock(z_loan_mut(client_data->condition_mutex));
+
+  return RMW_RET_OK;
 }
\ No newline at end of file
@@ -1,35 +1,156 @@
+#include "detail/events.h"
+#include "detail/identifiers.h"
+#include "detail/publisher.h"
+#include "detail/subscription.h"
 #include "rcutils/macros.h"
+#include "rmw/check_type_identifiers_match.h"
+#include "rmw/error_handling.h"
 #include "rmw/event.h"
 #include "rmw/rmw.h"
 
+static bool is_publisher_event(rmw_zp_event_type_t event_type) {
+  switch (event_type) {
+    case RMW_ZP_EVENT_OFFERED_DEADLINE_MISSED:
+      return true;
+    default:
+      return false;
+  }
+}
+
+static bool is_subscription_event(rmw_zp_event_type_t event_type) {
+  switch (event_type) {
+    case RMW_ZP_EVENT_MESSAGE_LOST:
+    case RMW_ZP_EVENT_REQUESTED_DEADLINE_MISSED:
+      return true;
+    default:
+      return false;
+  }
+}
+
+static rmw_ret_t get_event_data(const rmw_event_t* event, rmw_zp_events_t** events,
+                                rmw_zp_event_type_t* event_type) {
+  RMW_CHECK_ARGUMENT_FOR_NULL(event, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(event, event->implementation_identifier, rmw_zp_identifier,
+                                   return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+
+  *events = event->data;
+  RMW_CHECK_ARGUMENT_FOR_NULL(*events, RMW_RET_INVALID_ARGUMENT);
+
+  if (!rmw_zp_event_type_from_rmw(event->event_type, event_type)) {
+    RMW_SET_ERROR_MSG_WITH_FORMAT_STRING("Unsupported event type %d", (int)event->event_type);
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+
+  return RMW_RET_OK;
+}
+
 rmw_ret_t rmw_publisher_event_init(rmw_event_t* rmw_event, const rmw_publisher_t* publisher,
                                    rmw_event_type_t event_type) {
-  RCUTILS_UNUSED(rmw_event);
-  RCUTILS_UNUSED(publisher);
-  RCUTILS_UNUSED(event_type);
-  return RMW_RET_UNSUPPORTED;
+  RMW_CHECK_ARGUMENT_FOR_NULL(rmw_event, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(publisher, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(publisher, publisher->implementation_identifier,
+                                   rmw_zp_identifier, return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+
+  rmw_zp_publisher_t* pub_data = publisher->data;
+  RMW_CHECK_ARGUMENT_FOR_NULL(pub_data, RMW_RET_INVALID_ARGUMENT);
+
+  rmw_zp_event_type_t zp_event_type;
+  if (!rmw_zp_event_type_from_rmw(event_type, &zp_event_type) ||
+      !is_publisher_event(zp_event_type)) {
+    RMW_SET_ERROR_MSG_WITH_FORMAT_STRING("Event type %d is not supported for publishers",
+                                         (int)event_type);
+    return RMW_RET_UNSUPPORTED;
+  }
+
+  rmw_event->implementation_identifier = rmw_zp_identifier;
+  rmw_event->data = &pub_data->events;
+  rmw_event->event_type = event_type;
+
+  return RMW_RET_OK;
 }
 
 rmw_ret_t rmw_subscription_event_init(rmw_event_t* rmw_event,
                                       const rmw_subscription_t* subscription,
                                       rmw_event_type_t event_type) {
-  RCUTILS_UNUSED(rmw_event);
-  RCUTILS_UNUSED(subscription);
-  RCUTILS_UNUSED(event_type);
-  return RMW_RET_UNSUPPORTED;
+  RMW_CHECK_ARGUMENT_FOR_NULL(rmw_event, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(subscription, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(subscription, subscription->implementation_identifier,
+                                   rmw_zp_identifier, return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+
+  rmw_zp_subscription_t* sub_data = subscription->data;
+  RMW_CHECK_ARGUMENT_FOR_NULL(sub_data, RMW_RET_INVALID_ARGUMENT);
+
+  rmw_zp_event_type_t zp_event_type;
+  if (!rmw_zp_event_type_from_rmw(event_type, &zp_event_type) ||
+      !is_subscription_event(zp_event_type)) {
+    RMW_SET_ERROR_MSG_WITH_FORMAT_STRING("Event type %d is not supported for subscriptions",
+                                         (int)event_type);
+    return RMW_RET_UNSUPPORTED;
+  }
+
+  rmw_event->implementation_identifier = rmw_zp_identifier;
+  rmw_event->data = &sub_data->events;
+  rmw_event->event_type = event_type;
+
+  return RMW_RET_OK;
 }
 
 rmw_ret_t rmw_event_set_callback(rmw_event_t* event, rmw_event_callback_t callback,
                                  const void* user_data) {
-  RCUTILS_UNUSED(event);
-  RCUTILS_UNUSED(callback);
-  RCUTILS_UNUSED(user_data);
-  return RMW_RET_UNSUPPORTED;
+  rmw_zp_events_t* events;
+  rmw_zp_event_type_t event_type;
+  rmw_ret_t ret = get_event_data(event, &events, &event_type);
+  if (ret != RMW_RET_OK) {
+    return ret;
+  }
+
+  rmw_zp_events_set_callback(events, event_type, callback, user_data);
+
+  return RMW_RET_OK;
 }
 
 rmw_ret_t rmw_take_event(const rmw_event_t* event_handle, void* event_info, bool* taken) {
-  RCUTILS_UNUSED(event_handle);
-  RCUTILS_UNUSED(event_info);
-  RCUTILS_UNUSED(taken);
-  return RMW_RET_UNSUPPORTED;
+  RMW_CHECK_ARGUMENT_FOR_NULL(event_info, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(taken, RMW_RET_INVALID_ARGUMENT);
+
+  *taken = false;
+
+  rmw_zp_events_t* events;
+  rmw_zp_event_type_t event_type;
+  rmw_ret_t ret = get_event_data(event_handle, &events, &event_type);
+  if (ret != RMW_RET_OK) {
+    return ret;
+  }
+
+  size_t total_count;
+  size_t total_count_change;
+  rmw_zp_events_take(events, event_type, &total_count, &total_count_change);
+
+  switch (event_type) {
+    case RMW_ZP_EVENT_MESSAGE_LOST: {
+      rmw_message_lost_status_t* status = event_info;
+      status->total_count = total_count;
+      status->total_count_change = total_count_change;
+      break;
+    }
+    case RMW_ZP_EVENT_REQUESTED_DEADLINE_MISSED: {
+      rmw_requested_deadline_missed_status_t* status = event_info;
+      status->total_count = (int32_t)total_count;
+      status->total_count_change = (int32_t)total_count_change;
+      break;
+    }
+    case RMW_ZP_EVENT_OFFERED_DEADLINE_MISSED: {
+      rmw_offered_deadline_missed_status_t* status = event_info;
+      status->total_count = (int32_t)total_count;
+      status->total_count_change = (int32_t)total_count_change;
+      break;
+    }
+    default:
+      RMW_SET_ERROR_MSG("Unsupported event type");
+      return RMW_RET_ERROR;
+  }
+
+  *taken = true;
+
+  return RMW_RET_OK;
 }
\ No newline at end of file
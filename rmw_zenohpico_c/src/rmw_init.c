@@ -1,3 +1,4 @@
+#include "detail/config.h"
 #include "detail/identifiers.h"
 #include "detail/macros.h"
 #include "detail/rmw_data_types.h"
@@ -46,6 +47,21 @@ rmw_ret_t rmw_init(const rmw_init_options_t* options, rmw_context_t* context) {
   // Initialize context's implementation
   context->impl->is_shutdown = false;
 
+  if ((ret = rmw_zp_config_init_from_env(&context->impl->config)) != RMW_RET_OK) {
+    goto fail_init_config;
+  }
+
+  if (z_mutex_init(&context->impl->attachment_mutex) < 0) {
+    RMW_SET_ERROR_MSG("Failed to initialize zenohpico mutex");
+    ret = RMW_RET_ERROR;
+    goto fail_init_attachment_mutex;
+  }
+
+  if ((ret = rmw_zp_timer_wheel_init(&context->impl->timer_wheel,
+                                     context->impl->config.timer_wheel_tick_us)) != RMW_RET_OK) {
+    goto fail_init_timer_wheel;
+  }
+
   // Initialize the zenoh session.
   if (z_open(&context->impl->session, z_move(context->options.impl->config), NULL) < 0) {
     RMW_SET_ERROR_MSG("Error setting up zenoh session");
@@ -78,6 +94,12 @@ fail_start_read_task:
 fail_create_graph_guard_condition:
   z_close(z_loan_mut(context->impl->session), NULL);
 fail_session_open:
+  RMW_UNUSED(rmw_zp_timer_wheel_stop(&context->impl->timer_wheel))
+  RMW_UNUSED(rmw_zp_timer_wheel_fini(&context->impl->timer_wheel))
+fail_init_timer_wheel:
+  z_drop(z_move(context->impl->attachment_mutex));
+fail_init_attachment_mutex:
+fail_init_config:
   RMW_UNUSED(rmw_init_options_fini(&context->options))
 fail_init_options_copy:
   allocator->deallocate(context->impl, allocator->state);
@@ -113,6 +135,12 @@ rmw_ret_t rmw_shutdown(rmw_context_t* context) {
     ret = RMW_RET_ERROR;
   }
 
+  // Entities may still be destroyed after shutdown, so the wheel itself lives until
+  // rmw_context_fini.
+  if (rmw_zp_timer_wheel_stop(&context->impl->timer_wheel) != RMW_RET_OK) {
+    ret = RMW_RET_ERROR;
+  }
+
   context->impl->is_shutdown = true;
 
   return ret;
@@ -131,11 +159,20 @@ rmw_ret_t rmw_context_fini(rmw_context_t* context) {
     return RMW_RET_INVALID_ARGUMENT;
   }
 
+  rmw_ret_t ret = rmw_zp_timer_wheel_fini(&context->impl->timer_wheel);
+
+  if (z_drop(z_move(context->impl->attachment_mutex)) < 0) {
+    RMW_SET_ERROR_MSG("Failed to drop zenohpico mutex");
+    ret = RMW_RET_ERROR;
+  }
+
   const rcutils_allocator_t* allocator = &context->options.allocator;
 
   allocator->deallocate(context->impl, allocator->state);
 
-  rmw_ret_t ret = rmw_init_options_fini(&context->options);
+  if (rmw_init_options_fini(&context->options) != RMW_RET_OK) {
+    ret = RMW_RET_ERROR;
+  }
 
   *context = rmw_get_zero_initialized_context();
 
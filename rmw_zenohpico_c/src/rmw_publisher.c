@@ -11,6 +11,7 @@
 #include "rmw/error_handling.h"
 #include "rmw/rmw.h"
 #include "rmw/validate_full_topic_name.h"
+#include "rmw_zenohpico_c/publisher.h"
 #include "rosidl_runtime_c/message_type_support_struct.h"
 #include "rosidl_typesupport_microxrcedds_c/message_type_support.h"
 
@@ -95,12 +96,19 @@ rmw_publisher_t *rmw_create_publisher(const rmw_node_t *node,
   RMW_CHECK_FOR_NULL_WITH_MSG(publisher_data, "failed to allocate memory for publisher data",
                               goto fail_allocate_publisher_data);
 
-  if (rmw_zp_publisher_init(publisher_data, qos_profile) != RMW_RET_OK) {
+  if (rmw_zp_publisher_init(publisher_data, qos_profile,
+                            context_impl->config.serialization_buffer_max_size,
+                            &context_impl->timer_wheel) != RMW_RET_OK) {
     goto fail_init_publisher_data;
   }
 
   z_random_fill(publisher_data->pub_gid, RMW_GID_STORAGE_SIZE);
 
+  if (rmw_zp_attachment_template_init(&publisher_data->attachment_template, publisher_data->pub_gid,
+                                      context_impl->config.attachment_format) != RMW_RET_OK) {
+    goto fail_init_attachment_template;
+  }
+
   // publisher_data->type_hash = message_type_support->get_type_hash_func(message_type_support);
   // publisher_data->type_support_impl = message_type_support->data;
 
@@ -115,11 +123,20 @@ rmw_publisher_t *rmw_create_publisher(const rmw_node_t *node,
     goto fail_init_type_support;
   }
 
+  // Loans need the introspection type support to allocate and initialize messages.
+  if (publisher_data->type_support->members != NULL) {
+    if (rmw_zp_loan_pool_init(&publisher_data->loan_pool, publisher_data->type_support->members,
+                              publisher_data->adapted_qos_profile.depth,
+                              allocator) != RMW_RET_OK) {
+      goto fail_init_loan_pool;
+    }
+  }
+
   publisher_data->context = node->context;
   rmw_publisher->data = publisher_data;
   rmw_publisher->implementation_identifier = rmw_zp_identifier;
   rmw_publisher->options = *publisher_options;
-  rmw_publisher->can_loan_messages = false;
+  rmw_publisher->can_loan_messages = rmw_zp_loan_pool_is_initialized(&publisher_data->loan_pool);
 
   rmw_publisher->topic_name = rcutils_strdup(topic_name, *allocator);
   RMW_CHECK_FOR_NULL_WITH_MSG(rmw_publisher->topic_name, "Failed to allocate topic name",
@@ -181,13 +198,15 @@ fail_create_zenoh_publisher:
 fail_create_zenoh_key:
   allocator->deallocate(type_hash_c_str, allocator->state);
 fail_allocate_type_hash_c_str:
+fail_init_loan_pool:
   rmw_zp_message_type_support_fini(publisher_data->type_support, allocator);
 fail_init_type_support:
   allocator->deallocate(publisher_data->type_support, allocator->state);
 fail_allocate_type_support:
+fail_init_attachment_template:
   allocator->deallocate((char *)rmw_publisher->topic_name, allocator->state);
 fail_allocate_topic_name:
-  rmw_zp_publisher_fini(publisher_data);
+  rmw_zp_publisher_fini(publisher_data, allocator);
 fail_init_publisher_data:
   allocator->deallocate(publisher_data, allocator->state);
 fail_allocate_publisher_data:
@@ -224,7 +243,7 @@ rmw_ret_t rmw_destroy_publisher(rmw_node_t *node, rmw_publisher_t *publisher) {
   allocator->deallocate(publisher_data->type_support, allocator->state);
   allocator->deallocate((char *)publisher->topic_name, allocator->state);
 
-  if (rmw_zp_publisher_fini(publisher_data) != RMW_RET_OK) {
+  if (rmw_zp_publisher_fini(publisher_data, allocator) != RMW_RET_OK) {
     ret = RMW_RET_ERROR;
   }
 
@@ -237,17 +256,59 @@ rmw_ret_t rmw_destroy_publisher(rmw_node_t *node, rmw_publisher_t *publisher) {
 rmw_ret_t rmw_borrow_loaned_message(const rmw_publisher_t *publisher,
                                     const rosidl_message_type_support_t *type_support,
                                     void **ros_message) {
-  RCUTILS_UNUSED(publisher);
-  RCUTILS_UNUSED(type_support);
-  RCUTILS_UNUSED(ros_message);
-  return RMW_RET_UNSUPPORTED;
+  RMW_CHECK_ARGUMENT_FOR_NULL(publisher, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(publisher, publisher->implementation_identifier,
+                                   rmw_zp_identifier, return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+  RMW_CHECK_ARGUMENT_FOR_NULL(type_support, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(ros_message, RMW_RET_INVALID_ARGUMENT);
+  if (*ros_message != NULL) {
+    RMW_SET_ERROR_MSG("ros_message argument is not NULL");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+
+  if (!publisher->can_loan_messages) {
+    RMW_SET_ERROR_MSG("Loaned messages are not supported for this publisher");
+    return RMW_RET_UNSUPPORTED;
+  }
+
+  rmw_zp_publisher_t *publisher_data = publisher->data;
+  RMW_CHECK_ARGUMENT_FOR_NULL(publisher_data, RMW_RET_INVALID_ARGUMENT);
+
+  const rosidl_message_type_support_t *message_type_support;
+  if (rmw_zp_find_message_type_support(type_support, &message_type_support) != RMW_RET_OK) {
+    return RMW_RET_ERROR;
+  }
+  if (message_type_support->data != publisher_data->type_support->callbacks) {
+    RMW_SET_ERROR_MSG("Type support does not match the type of the publisher");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+
+  void *message = rmw_zp_loan_pool_borrow(&publisher_data->loan_pool);
+  if (message == NULL) {
+    return RMW_RET_ERROR;  // Error message already set
+  }
+
+  *ros_message = message;
+
+  return RMW_RET_OK;
 }
 
 rmw_ret_t rmw_return_loaned_message_from_publisher(const rmw_publisher_t *publisher,
                                                    void *loaned_message) {
-  RCUTILS_UNUSED(publisher);
-  RCUTILS_UNUSED(loaned_message);
-  return RMW_RET_UNSUPPORTED;
+  RMW_CHECK_ARGUMENT_FOR_NULL(publisher, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(publisher, publisher->implementation_identifier,
+                                   rmw_zp_identifier, return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+  RMW_CHECK_ARGUMENT_FOR_NULL(loaned_message, RMW_RET_INVALID_ARGUMENT);
+
+  if (!publisher->can_loan_messages) {
+    RMW_SET_ERROR_MSG("Loaned messages are not supported for this publisher");
+    return RMW_RET_UNSUPPORTED;
+  }
+
+  rmw_zp_publisher_t *publisher_data = publisher->data;
+  RMW_CHECK_ARGUMENT_FOR_NULL(publisher_data, RMW_RET_INVALID_ARGUMENT);
+
+  return rmw_zp_loan_pool_return(&publisher_data->loan_pool, loaned_message);
 }
 
 rmw_ret_t rmw_publisher_count_matched_subscriptions(const rmw_publisher_t *publisher,
@@ -296,52 +357,25 @@ rmw_ret_t rmw_get_gid_for_publisher(const rmw_publisher_t *publisher, rmw_gid_t
   return RMW_RET_OK;
 }
 
-rmw_ret_t rmw_publish(const rmw_publisher_t *publisher, const void *ros_message,
-                      rmw_publisher_allocation_t *allocation) {
-  RCUTILS_UNUSED(allocation);
-
-  RMW_CHECK_FOR_NULL_WITH_MSG(publisher, "publisher handle is null",
-                              return RMW_RET_INVALID_ARGUMENT);
-  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(publisher, publisher->implementation_identifier,
-                                   rmw_zp_identifier, return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
-  RMW_CHECK_FOR_NULL_WITH_MSG(ros_message, "ros message handle is null",
-                              return RMW_RET_INVALID_ARGUMENT);
-
-  rmw_zp_publisher_t *publisher_data = publisher->data;
-  RMW_CHECK_FOR_NULL_WITH_MSG(publisher_data, "publisher_data is null",
-                              return RMW_RET_INVALID_ARGUMENT);
-
-  rcutils_allocator_t *allocator = &(publisher_data->context->options.allocator);
-
-  // Serialize data.
-  size_t serialized_size =
-      rmw_zp_message_type_support_get_serialized_size(publisher_data->type_support, ros_message);
-
-  // To store serialized message byte array.
-  uint8_t *msg_bytes = allocator->allocate(serialized_size, allocator->state);
-  RMW_CHECK_FOR_NULL_WITH_MSG(msg_bytes, "bytes for message is null", return RMW_RET_BAD_ALLOC);
-
-  if (rmw_zp_message_type_support_serialize(publisher_data->type_support, ros_message, msg_bytes,
-                                            serialized_size) != RMW_RET_OK) {
-    goto fail_serialize_ros_message;
-  }
-
+// Publish an already serialized CDR payload along with a freshly generated attachment. The payload
+// is handed to zenoh without copying it, it only needs to stay valid until this returns.
+static rmw_ret_t publish_payload(rmw_zp_publisher_t *publisher_data, const uint8_t *payload_bytes,
+                                 size_t payload_len) {
   // create attachment
   int64_t sequence_number = rmw_zp_publisher_get_next_sequence_number(publisher_data);
 
   int64_t source_timestamp;
   if (rmw_zp_get_current_timestamp(&source_timestamp) != RMW_RET_OK) {
-    goto fail_get_current_timestamp;
+    return RMW_RET_ERROR;
   }
 
-  rmw_zp_attachment_data_t attachment_data = {.sequence_number = sequence_number,
-                                              .source_timestamp = source_timestamp};
-  memcpy(attachment_data.source_gid, publisher_data->pub_gid, RMW_GID_STORAGE_SIZE);
+  // Like the payload, the attachment only needs to outlive the put.
+  uint8_t attachment_bytes[RMW_ZP_ATTACHMENT_TEMPLATE_MAX_SIZE];
+  rmw_zp_attachment_template_fill(&publisher_data->attachment_template, sequence_number,
+                                  source_timestamp, attachment_bytes);
 
   z_owned_bytes_t attachment;
-  if (rmw_zp_attachment_data_serialize_to_zbytes(&attachment_data, &attachment) != RMW_RET_OK) {
-    goto fail_serialize_attachment;
-  }
+  z_bytes_from_static_buf(&attachment, attachment_bytes, publisher_data->attachment_template.size);
 
   // The encoding is simply forwarded and is useful when key expressions in the
   // session use different encoding formats. In our case, all key expressions
@@ -351,39 +385,128 @@ rmw_ret_t rmw_publish(const rmw_publisher_t *publisher, const void *ros_message,
   options.attachment = z_move(attachment);
 
   z_owned_bytes_t payload;
-  z_bytes_from_static_buf(&payload, msg_bytes, serialized_size);
+  z_bytes_from_static_buf(&payload, payload_bytes, payload_len);
 
   if (z_publisher_put(z_loan(publisher_data->pub), z_move(payload), &options)) {
     RMW_SET_ERROR_MSG("unable to publish message");
-    goto fail_publish_message;
+    z_drop(options.attachment);
+    return RMW_RET_ERROR;
   }
 
-  allocator->deallocate(msg_bytes, allocator->state);
+  rmw_zp_deadline_record_activity(&publisher_data->deadline);
 
   return RMW_RET_OK;
+}
 
-fail_publish_message:
-  z_drop(options.attachment);
-fail_serialize_attachment:
-fail_get_current_timestamp:
-fail_serialize_ros_message:
-  allocator->deallocate(msg_bytes, allocator->state);
-  return RMW_RET_ERROR;
+static rmw_ret_t publish_ros_message(rmw_zp_publisher_t *publisher_data, const void *ros_message) {
+  rcutils_allocator_t *allocator = &(publisher_data->context->options.allocator);
+
+  // Serialize data.
+  size_t serialized_size =
+      rmw_zp_message_type_support_get_serialized_size(publisher_data->type_support, ros_message);
+
+  // To store serialized message byte array.
+  bool is_shared;
+  uint8_t *msg_bytes = rmw_zp_publisher_acquire_serialization_buffer(
+      publisher_data, serialized_size, allocator, &is_shared);
+  RMW_CHECK_FOR_NULL_WITH_MSG(msg_bytes, "bytes for message is null", return RMW_RET_BAD_ALLOC);
+
+  rmw_ret_t ret = rmw_zp_message_type_support_serialize(publisher_data->type_support, ros_message,
+                                                        msg_bytes, serialized_size);
+  if (ret == RMW_RET_OK) {
+    ret = publish_payload(publisher_data, msg_bytes, serialized_size);
+  }
+
+  rmw_zp_publisher_release_serialization_buffer(publisher_data, msg_bytes, is_shared, allocator);
+
+  return ret;
+}
+
+rmw_ret_t rmw_publish(const rmw_publisher_t *publisher, const void *ros_message,
+                      rmw_publisher_allocation_t *allocation) {
+  RCUTILS_UNUSED(allocation);
+
+  RMW_CHECK_FOR_NULL_WITH_MSG(publisher, "publisher handle is null",
+                              return RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(publisher, publisher->implementation_identifier,
+                                   rmw_zp_identifier, return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+  RMW_CHECK_FOR_NULL_WITH_MSG(ros_message, "ros message handle is null",
+                              return RMW_RET_INVALID_ARGUMENT);
+
+  rmw_zp_publisher_t *publisher_data = publisher->data;
+  RMW_CHECK_FOR_NULL_WITH_MSG(publisher_data, "publisher_data is null",
+                              return RMW_RET_INVALID_ARGUMENT);
+
+  return publish_ros_message(publisher_data, ros_message);
 }
 
 rmw_ret_t rmw_publish_loaned_message(const rmw_publisher_t *publisher, void *ros_message,
                                      rmw_publisher_allocation_t *allocation) {
-  RCUTILS_UNUSED(publisher);
-  RCUTILS_UNUSED(ros_message);
   RCUTILS_UNUSED(allocation);
-  return RMW_RET_UNSUPPORTED;
+
+  RMW_CHECK_FOR_NULL_WITH_MSG(publisher, "publisher handle is null",
+                              return RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(publisher, publisher->implementation_identifier,
+                                   rmw_zp_identifier, return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+  RMW_CHECK_FOR_NULL_WITH_MSG(ros_message, "ros message handle is null",
+                              return RMW_RET_INVALID_ARGUMENT);
+
+  if (!publisher->can_loan_messages) {
+    RMW_SET_ERROR_MSG("Loaned messages are not supported for this publisher");
+    return RMW_RET_UNSUPPORTED;
+  }
+
+  rmw_zp_publisher_t *publisher_data = publisher->data;
+  RMW_CHECK_FOR_NULL_WITH_MSG(publisher_data, "publisher_data is null",
+                              return RMW_RET_INVALID_ARGUMENT);
+
+  // The message is serialized straight from the loan, then the loan goes back to the pool
+  // regardless of the outcome, as the middleware owns it again once this is called.
+  rmw_ret_t ret = publish_ros_message(publisher_data, ros_message);
+
+  if (rmw_zp_loan_pool_return(&publisher_data->loan_pool, ros_message) != RMW_RET_OK) {
+    ret = RMW_RET_ERROR;
+  }
+
+  return ret;
 }
 
 rmw_ret_t rmw_publish_serialized_message(const rmw_publisher_t *publisher,
                                          const rmw_serialized_message_t *serialized_message,
                                          rmw_publisher_allocation_t *allocation) {
-  RCUTILS_UNUSED(publisher);
-  RCUTILS_UNUSED(serialized_message);
   RCUTILS_UNUSED(allocation);
-  return RMW_RET_ERROR;
+
+  RMW_CHECK_FOR_NULL_WITH_MSG(publisher, "publisher handle is null",
+                              return RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(publisher, publisher->implementation_identifier,
+                                   rmw_zp_identifier, return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+  RMW_CHECK_FOR_NULL_WITH_MSG(serialized_message, "serialized message handle is null",
+                              return RMW_RET_INVALID_ARGUMENT);
+
+  rmw_zp_publisher_t *publisher_data = publisher->data;
+  RMW_CHECK_FOR_NULL_WITH_MSG(publisher_data, "publisher_data is null",
+                              return RMW_RET_INVALID_ARGUMENT);
+
+  // The serialized message already is a CDR buffer with its encapsulation header, exactly what
+  // rmw_publish puts on the wire, so it is published in place.
+  return publish_payload(publisher_data, serialized_message->buffer,
+                         serialized_message->buffer_length);
+}
+
+rmw_ret_t rmw_zenohpico_publisher_get_statistics(
+    const rmw_publisher_t *publisher, rmw_zenohpico_publisher_statistics_t *statistics) {
+  RMW_CHECK_ARGUMENT_FOR_NULL(publisher, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(publisher, publisher->implementation_identifier,
+                                   rmw_zp_identifier, return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+  RMW_CHECK_ARGUMENT_FOR_NULL(statistics, RMW_RET_INVALID_ARGUMENT);
+
+  rmw_zp_publisher_t *pub_data = publisher->data;
+  RMW_CHECK_ARGUMENT_FOR_NULL(pub_data, RMW_RET_INVALID_ARGUMENT);
+
+  z_mutex_lock(z_loan_mut(pub_data->serialization_buffer_mutex));
+  statistics->serialization_buffer_capacity = pub_data->serialization_buffer_capacity;
+  statistics->serialization_buffer_fallback_count = pub_data->serialization_buffer_fallback_count;
+  z_mutex_unlock(z_loan_mut(pub_data->serialization_buffer_mutex));
+
+  return RMW_RET_OK;
 }
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include "rmw/check_type_identifiers_match.h"
 #include "rmw/rmw.h"
 #include "rmw/validate_full_topic_name.h"
+#include "rmw_zenohpico_c/service.h"
 
 rmw_service_t* rmw_create_service(const rmw_node_t* node,
                                   const rosidl_service_type_support_t* type_supports,
@@ -54,7 +55,9 @@ rmw_service_t* rmw_create_service(const rmw_node_t* node,
   RMW_CHECK_FOR_NULL_WITH_MSG(service_data, "failed to allocate memory for service data",
                               goto fail_allocate_service_data);
 
-  if (rmw_zp_service_init(service_data, qos_profile, allocator) != RMW_RET_OK) {
+  if (rmw_zp_service_init(service_data, qos_profile,
+                          context_impl->config.service_max_pending_queries,
+                          allocator) != RMW_RET_OK) {
     goto fail_init_service_data;
   }
 
@@ -221,16 +224,23 @@ rmw_ret_t rmw_take_request(const rmw_service_t* service, rmw_service_info_t* req
     return RMW_RET_ERROR;
   }
 
-  const uint8_t* payload = z_slice_data(z_loan(query_data.payload));
-  const size_t payload_len = z_slice_len(z_loan(query_data.payload));
+  rcutils_allocator_t* allocator = &service_data->context->options.allocator;
 
-  if (rmw_zp_service_type_support_deserialize_request(service_data->type_support, payload,
-                                                      payload_len, ros_request) != RMW_RET_OK) {
-    z_drop(z_move(query_data.payload));
+  rmw_zp_payload_view_t payload;
+  if (rmw_zp_message_get_payload_view(&query_data, allocator, &payload) != RMW_RET_OK) {
+    rmw_zp_message_fini(&query_data);
     return RMW_RET_ERROR;
   }
 
-  z_drop(z_move(query_data.payload));
+  rmw_ret_t ret = rmw_zp_service_type_support_deserialize_request(
+      service_data->type_support, payload.data, payload.len, ros_request);
+
+  rmw_zp_payload_view_fini(&payload, allocator);
+  rmw_zp_message_fini(&query_data);
+
+  if (ret != RMW_RET_OK) {
+    return RMW_RET_ERROR;
+  }
 
   request_header->received_timestamp = query_data.received_timestamp;
   request_header->request_id.sequence_number = query_data.attachment_data.sequence_number;
@@ -287,8 +297,12 @@ rmw_ret_t rmw_send_response(const rmw_service_t* service, rmw_request_id_t* requ
     goto fail_get_current_timestamp;
   }
 
+  const rmw_zp_attachment_format_t attachment_format =
+      service_data->context->impl->config.attachment_format;
+
   z_owned_bytes_t attachment;
-  if (rmw_zp_attachment_data_serialize_to_zbytes(&attachment_data, &attachment) != RMW_RET_OK) {
+  if (rmw_zp_attachment_data_serialize_to_zbytes(&attachment_data, attachment_format,
+                                                  &attachment) != RMW_RET_OK) {
     goto fail_serialize_attachment;
   }
 
@@ -325,8 +339,33 @@ fail_allocate_response_bytes:
 rmw_ret_t rmw_service_set_on_new_request_callback(rmw_service_t* service,
                                                   rmw_event_callback_t callback,
                                                   const void* user_data) {
-  RCUTILS_UNUSED(service);
-  RCUTILS_UNUSED(callback);
-  RCUTILS_UNUSED(user_data);
-  return RMW_RET_UNSUPPORTED;
+  RMW_CHECK_ARGUMENT_FOR_NULL(service, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(service, service->implementation_identifier, rmw_zp_identifier,
+                                   return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+
+  rmw_zp_service_t* service_data = service->data;
+  RMW_CHECK_ARGUMENT_FOR_NULL(service_data, RMW_RET_INVALID_ARGUMENT);
+
+  rmw_zp_service_set_data_callback(service_data, callback, user_data);
+
+  return RMW_RET_OK;
+}
+
+rmw_ret_t rmw_zenohpico_service_get_statistics(const rmw_service_t* service,
+                                               rmw_zenohpico_service_statistics_t* statistics) {
+  RMW_CHECK_ARGUMENT_FOR_NULL(service, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(service, service->implementation_identifier, rmw_zp_identifier,
+                                   return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+  RMW_CHECK_ARGUMENT_FOR_NULL(statistics, RMW_RET_INVALID_ARGUMENT);
+
+  rmw_zp_service_t* service_data = service->data;
+  RMW_CHECK_ARGUMENT_FOR_NULL(service_data, RMW_RET_INVALID_ARGUMENT);
+
+  z_mutex_lock(z_loan_mut(service_data->query_map_mutex));
+  statistics->pending_request_count = rmw_zp_query_map_size(&service_data->query_map);
+  statistics->rejected_request_count = service_data->rejected_request_count;
+  statistics->request_queue_overflow_count = service_data->request_queue_overflow_count;
+  z_mutex_unlock(z_loan_mut(service_data->query_map_mutex));
+
+  return RMW_RET_OK;
 }
\ No newline at end of file
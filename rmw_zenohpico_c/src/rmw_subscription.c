@@ -1,6 +1,8 @@
 #include <inttypes.h>
 
 #include "detail/identifiers.h"
+#include "detail/introspection.h"
+#include "detail/macros.h"
 #include "detail/node.h"
 #include "detail/rmw_data_types.h"
 #include "detail/ros_topic_name_to_zenoh_key.h"
@@ -10,6 +12,11 @@
 #include "rmw/check_type_identifiers_match.h"
 #include "rmw/error_handling.h"
 #include "rmw/rmw.h"
+#include "rmw_zenohpico_c/subscription.h"
+
+// Number of messages rmw_take_sequence claims from the queue at once. Bounded so that a batch fits
+// on the stack.
+#define RMW_ZP_TAKE_SEQUENCE_BATCH_SIZE 16
 
 rmw_ret_t rmw_init_subscription_allocation(const rosidl_message_type_support_t* type_support,
                                            const rosidl_runtime_c__Sequence__bound* message_bounds,
@@ -69,7 +76,8 @@ rmw_subscription_t* rmw_create_subscription(
   RMW_CHECK_FOR_NULL_WITH_MSG(sub_data, "failed to allocate memory for subscription data",
                               goto fail_allocate_subscription_data);
 
-  if (rmw_zp_subscription_init(sub_data, qos_profile, allocator) != RMW_RET_OK) {
+  if (rmw_zp_subscription_init(sub_data, qos_profile, allocator, &context_impl->timer_wheel) !=
+      RMW_RET_OK) {
     goto fail_init_subscription_data;
   }
 
@@ -83,6 +91,16 @@ rmw_subscription_t* rmw_create_subscription(
     goto fail_init_type_support;
   }
 
+  // Loans need the introspection type support to allocate and initialize messages, and to
+  // deserialize into them. The messages are only allocated on the first loan.
+  if (sub_data->type_support->members != NULL &&
+      rmw_zp_introspection_can_deserialize(sub_data->type_support->members)) {
+    if (rmw_zp_loan_pool_init(&sub_data->loan_pool, sub_data->type_support->members,
+                              sub_data->adapted_qos_profile.depth, allocator) != RMW_RET_OK) {
+      goto fail_init_loan_pool;
+    }
+  }
+
   sub_data->context = node->context;
 
   rmw_subscription->data = sub_data;
@@ -93,7 +111,7 @@ rmw_subscription_t* rmw_create_subscription(
                               goto fail_allocate_topic_name);
 
   rmw_subscription->options = *subscription_options;
-  rmw_subscription->can_loan_messages = false;
+  rmw_subscription->can_loan_messages = rmw_zp_loan_pool_is_initialized(&sub_data->loan_pool);
   rmw_subscription->is_cft_enabled = false;
 
   // Convert the type hash to a string so that it can be included in the keyexpr.
@@ -143,6 +161,7 @@ fail_create_zenoh_key:
 fail_allocate_type_hash_c_str:
   allocator->deallocate((char*)rmw_subscription->topic_name, allocator->state);
 fail_allocate_topic_name:
+fail_init_loan_pool:
   rmw_zp_message_type_support_fini(sub_data->type_support, allocator->state);
 fail_init_type_support:
   allocator->deallocate(sub_data->type_support, allocator->state);
@@ -232,41 +251,73 @@ rmw_ret_t rmw_subscription_get_content_filter(const rmw_subscription_t* subscrip
 rmw_ret_t rmw_subscription_set_on_new_message_callback(rmw_subscription_t* subscription,
                                                        rmw_event_callback_t callback,
                                                        const void* user_data) {
-  RCUTILS_UNUSED(subscription);
-  RCUTILS_UNUSED(callback);
-  RCUTILS_UNUSED(user_data);
-  return RMW_RET_UNSUPPORTED;
+  RMW_CHECK_ARGUMENT_FOR_NULL(subscription, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(subscription, subscription->implementation_identifier,
+                                   rmw_zp_identifier, return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+
+  rmw_zp_subscription_t* sub_data = subscription->data;
+  RMW_CHECK_ARGUMENT_FOR_NULL(sub_data, RMW_RET_INVALID_ARGUMENT);
+
+  rmw_zp_subscription_set_data_callback(sub_data, callback, user_data);
+
+  return RMW_RET_OK;
 }
 
-static rmw_ret_t take_one(rmw_zp_subscription_t* sub_data, void* ros_message, bool* taken,
-                          rmw_message_info_t* message_info) {
-  rmw_zp_message_t msg_data;
-  if (rmw_zp_subscription_pop_next_message(sub_data, &msg_data) != RMW_RET_OK) {
+// Deserialize a popped message into `ros_message` and finalize it. Loaned messages are reused
+// between takes, so they are deserialized with the introspection type support, which grows their
+// sequences and strings as needed.
+static rmw_ret_t deserialize_one(rmw_zp_subscription_t* sub_data, rmw_zp_message_t* msg_data,
+                                 void* ros_message, bool is_loaned,
+                                 rmw_message_info_t* message_info) {
+  rcutils_allocator_t* allocator = &sub_data->context->options.allocator;
+
+  rmw_zp_payload_view_t payload;
+  if (rmw_zp_message_get_payload_view(msg_data, allocator, &payload) != RMW_RET_OK) {
+    rmw_zp_message_fini(msg_data);
     return RMW_RET_ERROR;
   }
 
-  const uint8_t* payload = z_slice_data(z_loan(msg_data.payload));
-  const size_t payload_len = z_slice_len(z_loan(msg_data.payload));
+  rmw_ret_t ret;
+  if (is_loaned) {
+    ret = rmw_zp_message_type_support_deserialize_with_introspection(
+        sub_data->type_support, payload.data, payload.len, ros_message);
+  } else {
+    ret = rmw_zp_message_type_support_deserialize(sub_data->type_support, payload.data,
+                                                  payload.len, ros_message);
+  }
+
+  rmw_zp_payload_view_fini(&payload, allocator);
+  rmw_zp_message_fini(msg_data);
 
-  if (rmw_zp_message_type_support_deserialize(sub_data->type_support, payload, payload_len,
-                                              ros_message) != RMW_RET_OK) {
-    z_drop(z_move(msg_data.payload));
+  if (ret != RMW_RET_OK) {
     return RMW_RET_ERROR;
   }
 
-  z_drop(z_move(msg_data.payload));
-
   if (message_info != NULL) {
     message_info->reception_sequence_number = 0;
     message_info->publisher_gid.implementation_identifier = rmw_zp_identifier;
     message_info->from_intra_process = false;
-    message_info->received_timestamp = msg_data.received_timestamp;
-    message_info->source_timestamp = msg_data.attachment_data.source_timestamp;
-    message_info->publication_sequence_number = msg_data.attachment_data.sequence_number;
-    memcpy(message_info->publisher_gid.data, msg_data.attachment_data.source_gid,
+    message_info->received_timestamp = msg_data->received_timestamp;
+    message_info->source_timestamp = msg_data->attachment_data.source_timestamp;
+    message_info->publication_sequence_number = msg_data->attachment_data.sequence_number;
+    memcpy(message_info->publisher_gid.data, msg_data->attachment_data.source_gid,
            RMW_GID_STORAGE_SIZE);
   }
 
+  return RMW_RET_OK;
+}
+
+static rmw_ret_t take_one(rmw_zp_subscription_t* sub_data, void* ros_message, bool is_loaned,
+                          bool* taken, rmw_message_info_t* message_info) {
+  rmw_zp_message_t msg_data;
+  if (!rmw_zp_subscription_pop_next_message(sub_data, &msg_data)) {
+    return RMW_RET_OK;
+  }
+
+  if (deserialize_one(sub_data, &msg_data, ros_message, is_loaned, message_info) != RMW_RET_OK) {
+    return RMW_RET_ERROR;
+  }
+
   *taken = true;
 
   return RMW_RET_OK;
@@ -276,21 +327,31 @@ static rmw_ret_t take_one_serialized(rmw_zp_subscription_t* sub_data,
                                      rmw_serialized_message_t* serialized_message, bool* taken,
                                      rmw_message_info_t* message_info) {
   rmw_zp_message_t msg_data;
-  if (rmw_zp_subscription_pop_next_message(sub_data, &msg_data) != RMW_RET_OK) {
-    return RMW_RET_ERROR;
+  if (!rmw_zp_subscription_pop_next_message(sub_data, &msg_data)) {
+    return RMW_RET_OK;
   }
 
-  const uint8_t* payload = z_slice_data(z_loan(msg_data.payload));
-  const size_t payload_len = z_slice_len(z_loan(msg_data.payload));
+  const z_loaned_bytes_t* payload = z_loan(msg_data.payload);
+  const size_t payload_len = z_bytes_len(payload);
 
   if (serialized_message->buffer_capacity < payload_len) {
     rmw_ret_t ret = rmw_serialized_message_resize(serialized_message, payload_len);
     if (ret != RMW_RET_OK) {
+      rmw_zp_message_fini(&msg_data);
       return ret;  // Error message already set
     }
   }
+
+  // The payload is copied straight into the serialized message, whether it is fragmented or not.
+  z_bytes_reader_t reader = z_bytes_get_reader(payload);
+  if (z_bytes_reader_read(&reader, serialized_message->buffer, payload_len) != payload_len) {
+    RMW_SET_ERROR_MSG("Failed to read message payload");
+    rmw_zp_message_fini(&msg_data);
+    return RMW_RET_ERROR;
+  }
   serialized_message->buffer_length = payload_len;
-  memcpy(serialized_message->buffer, payload, payload_len);
+
+  rmw_zp_message_fini(&msg_data);
 
   *taken = true;
 
@@ -324,7 +385,7 @@ rmw_ret_t rmw_take(const rmw_subscription_t* subscription, void* ros_message, bo
 
   rmw_zp_subscription_t* sub_data = subscription->data;
 
-  return take_one(sub_data, ros_message, taken, NULL);
+  return take_one(sub_data, ros_message, false, taken, NULL);
 }
 
 rmw_ret_t rmw_take_with_info(const rmw_subscription_t* subscription, void* ros_message, bool* taken,
@@ -345,7 +406,7 @@ rmw_ret_t rmw_take_with_info(const rmw_subscription_t* subscription, void* ros_m
 
   rmw_zp_subscription_t* sub_data = subscription->data;
 
-  return take_one(sub_data, ros_message, taken, message_info);
+  return take_one(sub_data, ros_message, false, taken, message_info);
 }
 
 rmw_ret_t rmw_take_sequence(const rmw_subscription_t* subscription, size_t count,
@@ -392,29 +453,36 @@ rmw_ret_t rmw_take_sequence(const rmw_subscription_t* subscription, size_t count
     return RMW_RET_OK;
   }
 
-  rmw_ret_t ret;
+  rmw_ret_t ret = RMW_RET_OK;
 
-  while (*taken < count) {
-    bool one_taken = false;
+  // Messages are popped in batches, each claimed from the queue at once, and only deserialized
+  // afterwards. An empty queue simply ends the take, and so does a failure once the batch it
+  // happened in is done.
+  rmw_zp_message_t batch[RMW_ZP_TAKE_SEQUENCE_BATCH_SIZE];
 
-    ret = take_one(sub_data, message_sequence->data[*taken], &one_taken,
-                   &message_info_sequence->data[*taken]);
-    if (ret != RMW_RET_OK) {
-      // If we are taking a sequence and the 2nd take in the sequence failed,
-      // we'll report RMW_RET_ERROR to the caller, but we will *also* tell the
-      // caller that there are valid messages already taken (via the
-      // message_sequence size).  It is up to the caller to deal with that
-      // situation appropriately.
-      break;
+  while (*taken < count && ret == RMW_RET_OK) {
+    size_t batch_count = count - *taken;
+    if (batch_count > RMW_ZP_TAKE_SEQUENCE_BATCH_SIZE) {
+      batch_count = RMW_ZP_TAKE_SEQUENCE_BATCH_SIZE;
     }
 
-    if (!one_taken) {
-      // No error, but there was nothing left to be taken, so break out of the
-      // loop
+    batch_count = rmw_zp_subscription_pop_messages(sub_data, batch, batch_count);
+    if (batch_count == 0) {
       break;
     }
 
-    (*taken)++;
+    // If a take in the sequence fails, we report RMW_RET_ERROR to the caller, but we *also*
+    // tell the caller that there are valid messages already taken (via the message_sequence
+    // size). It is up to the caller to deal with that situation appropriately. The rest of the
+    // batch is already claimed from the queue, so it is still taken rather than dropped.
+    for (size_t i = 0; i < batch_count; i++) {
+      if (deserialize_one(sub_data, &batch[i], message_sequence->data[*taken], false,
+                          &message_info_sequence->data[*taken]) == RMW_RET_OK) {
+        (*taken)++;
+      } else {
+        ret = RMW_RET_ERROR;
+      }
+    }
   }
 
   message_sequence->size = *taken;
@@ -436,6 +504,8 @@ rmw_ret_t rmw_take_serialized_message(const rmw_subscription_t* subscription,
   RMW_CHECK_TYPE_IDENTIFIERS_MATCH(subscription handle, subscription->implementation_identifier,
                                    rmw_zp_identifier, return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
 
+  *taken = false;
+
   rmw_zp_subscription_t* sub_data = subscription->data;
 
   return take_one_serialized(sub_data, serialized_message, taken, NULL);
@@ -456,35 +526,115 @@ rmw_ret_t rmw_take_serialized_message_with_info(const rmw_subscription_t* subscr
   RMW_CHECK_TYPE_IDENTIFIERS_MATCH(subscription handle, subscription->implementation_identifier,
                                    rmw_zp_identifier, return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
 
+  *taken = false;
+
   rmw_zp_subscription_t* sub_data = subscription->data;
 
   return take_one_serialized(sub_data, serialized_message, taken, message_info);
 }
 
+static rmw_ret_t take_one_loaned(rmw_zp_subscription_t* sub_data, void** loaned_message,
+                                 bool* taken, rmw_message_info_t* message_info) {
+  // Pooled messages are recycled as they are, so deserializing into them reuses the memory of
+  // their sequences and strings, which only grow when a larger sample arrives.
+  void* message = rmw_zp_loan_pool_borrow(&sub_data->loan_pool);
+  if (message == NULL) {
+    return RMW_RET_ERROR;  // Error message already set
+  }
+
+  rmw_ret_t ret = take_one(sub_data, message, true, taken, message_info);
+  if (ret != RMW_RET_OK || !*taken) {
+    RMW_UNUSED(rmw_zp_loan_pool_return(&sub_data->loan_pool, message));
+    return ret;
+  }
+
+  *loaned_message = message;
+
+  return RMW_RET_OK;
+}
+
 rmw_ret_t rmw_take_loaned_message(const rmw_subscription_t* subscription, void** loaned_message,
                                   bool* taken, rmw_subscription_allocation_t* allocation) {
-  RCUTILS_UNUSED(subscription);
-  RCUTILS_UNUSED(loaned_message);
-  RCUTILS_UNUSED(taken);
   RCUTILS_UNUSED(allocation);
-  return RMW_RET_UNSUPPORTED;
+
+  RMW_CHECK_ARGUMENT_FOR_NULL(subscription, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(subscription->data, RMW_RET_ERROR);
+  RMW_CHECK_ARGUMENT_FOR_NULL(loaned_message, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(taken, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(subscription handle, subscription->implementation_identifier,
+                                   rmw_zp_identifier, return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+
+  if (!subscription->can_loan_messages) {
+    RMW_SET_ERROR_MSG("Loaned messages are not supported for this subscription");
+    return RMW_RET_UNSUPPORTED;
+  }
+
+  *taken = false;
+
+  rmw_zp_subscription_t* sub_data = subscription->data;
+
+  return take_one_loaned(sub_data, loaned_message, taken, NULL);
 }
 
 rmw_ret_t rmw_take_loaned_message_with_info(const rmw_subscription_t* subscription,
                                             void** loaned_message, bool* taken,
                                             rmw_message_info_t* message_info,
                                             rmw_subscription_allocation_t* allocation) {
-  RCUTILS_UNUSED(subscription);
-  RCUTILS_UNUSED(loaned_message);
-  RCUTILS_UNUSED(taken);
-  RCUTILS_UNUSED(message_info);
   RCUTILS_UNUSED(allocation);
-  return RMW_RET_UNSUPPORTED;
+
+  RMW_CHECK_ARGUMENT_FOR_NULL(subscription, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(subscription->data, RMW_RET_ERROR);
+  RMW_CHECK_ARGUMENT_FOR_NULL(loaned_message, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(taken, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(message_info, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(subscription handle, subscription->implementation_identifier,
+                                   rmw_zp_identifier, return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+
+  if (!subscription->can_loan_messages) {
+    RMW_SET_ERROR_MSG("Loaned messages are not supported for this subscription");
+    return RMW_RET_UNSUPPORTED;
+  }
+
+  *taken = false;
+
+  rmw_zp_subscription_t* sub_data = subscription->data;
+
+  return take_one_loaned(sub_data, loaned_message, taken, message_info);
 }
 
 rmw_ret_t rmw_return_loaned_message_from_subscription(const rmw_subscription_t* subscription,
                                                       void* loaned_message) {
-  RCUTILS_UNUSED(subscription);
-  RCUTILS_UNUSED(loaned_message);
-  return RMW_RET_UNSUPPORTED;
+  RMW_CHECK_ARGUMENT_FOR_NULL(subscription, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(subscription->data, RMW_RET_ERROR);
+  RMW_CHECK_ARGUMENT_FOR_NULL(loaned_message, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(subscription handle, subscription->implementation_identifier,
+                                   rmw_zp_identifier, return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+
+  if (!subscription->can_loan_messages) {
+    RMW_SET_ERROR_MSG("Loaned messages are not supported for this subscription");
+    return RMW_RET_UNSUPPORTED;
+  }
+
+  rmw_zp_subscription_t* sub_data = subscription->data;
+
+  return rmw_zp_loan_pool_return(&sub_data->loan_pool, loaned_message);
 }
+
+rmw_ret_t rmw_zenohpico_subscription_get_statistics(
+    const rmw_subscription_t* subscription, rmw_zenohpico_subscription_statistics_t* statistics) {
+  RMW_CHECK_ARGUMENT_FOR_NULL(subscription, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(subscription, subscription->implementation_identifier,
+                                   rmw_zp_identifier, return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+  RMW_CHECK_ARGUMENT_FOR_NULL(statistics, RMW_RET_INVALID_ARGUMENT);
+
+  rmw_zp_subscription_t* sub_data = subscription->data;
+  RMW_CHECK_ARGUMENT_FOR_NULL(sub_data, RMW_RET_INVALID_ARGUMENT);
+
+  z_mutex_lock(z_loan_mut(sub_data->condition_mutex));
+  statistics->queue_overflow_count = sub_data->queue_overflow_count;
+  statistics->sequence_gap_count = sub_data->sequence_gap_count;
+  statistics->lifespan_expired_count = sub_data->lifespan_expired_count;
+  z_mutex_unlock(z_loan_mut(sub_data->condition_mutex));
+
+  return RMW_RET_OK;
+}
\ No newline at end of file
@@ -1,6 +1,11 @@
+#include <stdint.h>
+#include <string.h>
+
 #include "detail/client.h"
+#include "detail/events.h"
 #include "detail/guard_condition.h"
 #include "detail/identifiers.h"
+#include "detail/rmw_data_types.h"
 #include "detail/service.h"
 #include "detail/subscription.h"
 #include "detail/wait_set.h"
@@ -8,6 +13,7 @@
 #include "rmw/check_type_identifiers_match.h"
 #include "rmw/error_handling.h"
 #include "rmw/rmw.h"
+#include "rmw_zenohpico_c/wait_set.h"
 
 rmw_wait_set_t *rmw_create_wait_set(rmw_context_t *context, size_t max_conditions) {
   RCUTILS_UNUSED(max_conditions);
@@ -29,11 +35,12 @@ rmw_wait_set_t *rmw_create_wait_set(rmw_context_t *context, size_t max_condition
   RMW_CHECK_FOR_NULL_WITH_MSG(wait_set_data, "failed to allocate wait set data",
                               goto fail_allocate_wait_set_data);
 
-  if (rmw_zp_wait_set_init(wait_set_data) != RMW_RET_OK) {
+  if (rmw_zp_wait_set_init(wait_set_data, &context->impl->attachment_mutex) != RMW_RET_OK) {
     goto fail_init_wait_set_data;
   }
 
   wait_set_data->context = context;
+  wait_set_data->spin_period_us = context->impl->config.wait_spin_period_us;
   wait_set->data = wait_set_data;
 
   return wait_set;
@@ -65,88 +72,145 @@ rmw_ret_t rmw_destroy_wait_set(rmw_wait_set_t *wait_set) {
   return ret;
 }
 
-static bool check_and_attach_condition(const rmw_subscriptions_t *const subscriptions,
-                                       const rmw_guard_conditions_t *const guard_conditions,
-                                       const rmw_services_t *const services,
-                                       const rmw_clients_t *const clients,
-                                       const rmw_events_t *const events,
-                                       rmw_zp_wait_set_t *wait_set_data) {
-  if (guard_conditions) {
-    for (size_t i = 0; i < guard_conditions->guard_condition_count; ++i) {
-      rmw_zp_guard_condition_t *gc = guard_conditions->guard_conditions[i];
-      if (gc == NULL) {
-        continue;
-      }
-      if (rmw_zp_guard_condition_check_and_attach_condition_if_not(gc, wait_set_data)) {
-        return true;
-      }
-    }
+typedef struct {
+  void **entities;
+  size_t count;
+} entity_array_t;
+
+static void get_entity_arrays(rmw_subscriptions_t *subscriptions,
+                              rmw_guard_conditions_t *guard_conditions, rmw_services_t *services,
+                              rmw_clients_t *clients, rmw_events_t *events,
+                              entity_array_t arrays[RMW_ZP_WAITABLE_KIND_COUNT]) {
+  arrays[RMW_ZP_WAITABLE_GUARD_CONDITION] = (entity_array_t){
+      guard_conditions ? guard_conditions->guard_conditions : NULL,
+      guard_conditions ? guard_conditions->guard_condition_count : 0};
+  arrays[RMW_ZP_WAITABLE_SUBSCRIPTION] =
+      (entity_array_t){subscriptions ? subscriptions->subscribers : NULL,
+                       subscriptions ? subscriptions->subscriber_count : 0};
+  arrays[RMW_ZP_WAITABLE_SERVICE] = (entity_array_t){services ? services->services : NULL,
+                                                     services ? services->service_count : 0};
+  arrays[RMW_ZP_WAITABLE_CLIENT] =
+      (entity_array_t){clients ? clients->clients : NULL, clients ? clients->client_count : 0};
+  arrays[RMW_ZP_WAITABLE_EVENT] =
+      (entity_array_t){events ? events->events : NULL, events ? events->event_count : 0};
+}
+
+// Unlike the other entities, rmw_wait() is given the rmw_event_t of events.
+static rmw_ret_t attach_event(rmw_event_t *event, rmw_zp_wait_set_attachment_t *attachment) {
+  rmw_zp_event_type_t event_type;
+  if (event->data != NULL && rmw_zp_event_type_from_rmw(event->event_type, &event_type)) {
+    return rmw_zp_events_attach(event->data, event_type, attachment);
   }
+  return RMW_RET_OK;
+}
 
-  if (events) {
-    for (size_t i = 0; i < events->event_count; ++i) {
-      rmw_event_t *event = events->events[i];
-      // TODO(bjsowa)
-      //       rmw_zenoh_cpp::rmw_zenoh_event_type_t zenoh_event_type =
-      //           rmw_zenoh_cpp::zenoh_event_from_rmw_event(event->event_type);
-      //       if (zenoh_event_type == rmw_zenoh_cpp::ZENOH_EVENT_INVALID) {
-      //         RMW_SET_ERROR_MSG_WITH_FORMAT_STRING(
-      //             "has_triggered_condition() called with unknown event %u. Report "
-      //             "this bug.",
-      //             event->event_type);
-      //         continue;
-      //       }
-
-      //       auto event_data =
-      //           static_cast<rmw_zenoh_cpp::EventsManager *>(event->data);
-      //       if (event_data == nullptr) {
-      //         continue;
-      //       }
-
-      //       if (event_data->queue_has_data_and_attach_condition_if_not(
-      //               zenoh_event_type, wait_set_data)) {
-      //         return true;
-      //       }
-    }
+static bool event_has_event(rmw_event_t *event) {
+  rmw_zp_event_type_t event_type;
+  if (event->data != NULL && rmw_zp_event_type_from_rmw(event->event_type, &event_type)) {
+    return rmw_zp_events_has_event(event->data, event_type);
   }
+  return false;
+}
 
-  if (subscriptions) {
-    for (size_t i = 0; i < subscriptions->subscriber_count; ++i) {
-      rmw_zp_subscription_t *sub_data = subscriptions->subscribers[i];
-      if (sub_data == NULL) {
-        continue;
-      }
-      if (rmw_zp_subscription_queue_has_data_and_attach_condition_if_not(sub_data, wait_set_data)) {
-        return true;
-      }
+static bool attachments_match(rmw_zp_wait_set_t *wait_set_data, const entity_array_t *arrays) {
+  void **entities = wait_set_data->entities;
+  for (size_t kind = 0; kind < RMW_ZP_WAITABLE_KIND_COUNT; kind++) {
+    if (wait_set_data->entity_counts[kind] != arrays[kind].count) {
+      return false;
     }
+    if (arrays[kind].count > 0 &&
+        memcmp(entities, arrays[kind].entities, arrays[kind].count * sizeof(void *)) != 0) {
+      return false;
+    }
+    entities += arrays[kind].count;
   }
 
-  if (services) {
-    for (size_t i = 0; i < services->service_count; ++i) {
-      rmw_zp_service_t *serv_data = services->services[i];
-      if (serv_data == NULL) {
-        continue;
-      }
-      if (rmw_zp_service_queue_has_data_and_attach_condition_if_not(serv_data, wait_set_data)) {
-        return true;
-      }
-    }
+  z_mutex_lock(z_loan_mut(wait_set_data->condition_mutex));
+  bool attachments_changed = wait_set_data->attachments_changed;
+  z_mutex_unlock(z_loan_mut(wait_set_data->condition_mutex));
+
+  return !attachments_changed;
+}
+
+static rmw_ret_t update_attachments(rmw_zp_wait_set_t *wait_set_data,
+                                    const entity_array_t *arrays) {
+  size_t count = 0;
+  for (size_t kind = 0; kind < RMW_ZP_WAITABLE_KIND_COUNT; kind++) {
+    count += arrays[kind].count;
+  }
+
+  if (rmw_zp_wait_set_reset_attachments(wait_set_data, count) != RMW_RET_OK) {
+    return RMW_RET_ERROR;
   }
 
-  if (clients) {
-    for (size_t i = 0; i < clients->client_count; ++i) {
-      rmw_zp_client_t *client_data = clients->clients[i];
-      if (client_data == NULL) {
+  size_t offset = 0;
+  for (size_t kind = 0; kind < RMW_ZP_WAITABLE_KIND_COUNT; kind++) {
+    for (size_t i = 0; i < arrays[kind].count; ++i) {
+      void *entity = arrays[kind].entities[i];
+      rmw_zp_wait_set_attachment_t *attachment = &wait_set_data->attachments[offset + i];
+
+      wait_set_data->entities[offset + i] = entity;
+      rmw_zp_wait_set_attachment_init(attachment, wait_set_data, kind, i);
+      if (entity == NULL) {
         continue;
       }
-      if (rmw_zp_client_queue_has_data_and_attach_condition_if_not(client_data, wait_set_data)) {
-        return true;
+
+      rmw_ret_t ret = RMW_RET_OK;
+      switch (kind) {
+        case RMW_ZP_WAITABLE_GUARD_CONDITION:
+          ret = rmw_zp_guard_condition_attach(entity, attachment);
+          break;
+        case RMW_ZP_WAITABLE_SUBSCRIPTION:
+          ret = rmw_zp_subscription_attach(entity, attachment);
+          break;
+        case RMW_ZP_WAITABLE_SERVICE:
+          ret = rmw_zp_service_attach(entity, attachment);
+          break;
+        case RMW_ZP_WAITABLE_CLIENT:
+          ret = rmw_zp_client_attach(entity, attachment);
+          break;
+        case RMW_ZP_WAITABLE_EVENT:
+          ret = attach_event(entity, attachment);
+          break;
+      }
+      if (ret != RMW_RET_OK) {
+        // Keep what was attached so far, so that the next call detaches it.
+        wait_set_data->entity_counts[kind] = i + 1;
+        return ret;  // Error message already set
       }
     }
+    wait_set_data->entity_counts[kind] = arrays[kind].count;
+    offset += arrays[kind].count;
   }
 
-  return false;
+  return RMW_RET_OK;
+}
+
+// Return whether the entity of a ready attachment is still ready, and whether it should stay on
+// the ready list for the next call.
+static bool check_ready_attachment(rmw_zp_wait_set_attachment_t *attachment, void *entity,
+                                   bool *stays_ready) {
+  switch (attachment->kind) {
+    case RMW_ZP_WAITABLE_GUARD_CONDITION:
+      // Taking the trigger resets it.
+      *stays_ready = false;
+      return rmw_zp_guard_condition_take_trigger(entity);
+    case RMW_ZP_WAITABLE_SUBSCRIPTION:
+      *stays_ready = rmw_zp_subscription_has_data(entity);
+      return *stays_ready;
+    case RMW_ZP_WAITABLE_SERVICE:
+      *stays_ready = rmw_zp_service_has_data(entity);
+      return *stays_ready;
+    case RMW_ZP_WAITABLE_CLIENT:
+      *stays_ready = rmw_zp_client_has_data(entity);
+      return *stays_ready;
+    case RMW_ZP_WAITABLE_EVENT:
+      *stays_ready = event_has_event(entity);
+      return *stays_ready;
+    default:
+      *stays_ready = false;
+      return false;
+  }
 }
 
 static size_t rmw_time_to_us(const rmw_time_t *time) {
@@ -167,40 +231,68 @@ rmw_ret_t rmw_wait(rmw_subscriptions_t *subscriptions, rmw_guard_conditions_t *g
   // rmw_wait should return *all* entities that have data available, and let the
   // caller decide how to handle them.
   //
-  // If there is no data currently available in any of the entities we were told
-  // to wait on, we we attach a context-global condition variable to each
-  // entity, calculate a timeout based on wait_timeout, and then sleep on the
-  // condition variable.  If any of the entities has an event during that time,
-  // it will wake up from that sleep.
+  // The entities are attached to the wait set the first time they are given to rmw_wait(), and
+  // stay attached while the caller keeps passing the same ones. If any of them is ready, or
+  // becomes ready before wait_timeout expires, it is on the ready list of the wait set.
   //
-  // If there is data currently available in one or more of the entities, then
-  // we'll skip attaching the condition variable, and skip the sleep, and
-  // instead just go to the last part.
-  //
-  // In the last part, we check every entity and see if there are conditions
-  // that make it ready. If that entity is not ready, then we set the pointer to
-  // it to nullptr in the wait set, which signals to the upper layers that it
-  // isn't ready.  If something is ready, then we leave it as a valid pointer.
-
-  bool skip_wait = check_and_attach_condition(subscriptions, guard_conditions, services, clients,
-                                              events, wait_set_data);
-  if (!skip_wait) {
+  // In the last part, we go through the ready list only and check if the entities on it are still
+  // ready. Every other entity is set to NULL, which signals to the upper layers that it isn't
+  // ready. If something is ready, then we leave it as a valid pointer.
+
+  entity_array_t arrays[RMW_ZP_WAITABLE_KIND_COUNT];
+  get_entity_arrays(subscriptions, guard_conditions, services, clients, events, arrays);
+
+  if (!attachments_match(wait_set_data, arrays)) {
+    z_mutex_lock(z_loan_mut(*wait_set_data->attachment_mutex));
+    rmw_ret_t ret = update_attachments(wait_set_data, arrays);
+    z_mutex_unlock(z_loan_mut(*wait_set_data->attachment_mutex));
+    if (ret != RMW_RET_OK) {
+      return RMW_RET_ERROR;
+    }
+  }
+
+  // According to the RMW documentation, if wait_timeout is NULL that means
+  // "wait forever", if it specified as 0 it means "never wait", and if it is
+  // anything else wait for that amount of time.
+  const bool may_wait = wait_timeout == NULL || wait_timeout->sec != 0 || wait_timeout->nsec != 0;
+  const size_t wait_timeout_us = wait_timeout == NULL ? SIZE_MAX : rmw_time_to_us(wait_timeout);
+  z_clock_t clock_start = z_clock_now();
+
+  // According to the documentation for rmw_wait in rmw.h, entries in the
+  // various arrays that have *not* been triggered should be set to NULL
+  for (size_t kind = 0; kind < RMW_ZP_WAITABLE_KIND_COUNT; kind++) {
+    for (size_t i = 0; i < arrays[kind].count; ++i) {
+      arrays[kind].entities[i] = NULL;
+    }
+  }
+
+  z_mutex_lock(z_loan_mut(wait_set_data->condition_mutex));
+
+  if (may_wait && wait_set_data->ready_list == NULL && wait_set_data->spin_period_us > 0) {
+    // Poll for a while before paying for being woken up through the condition variable.
+    const size_t spin_period_us = wait_set_data->spin_period_us < wait_timeout_us
+                                      ? wait_set_data->spin_period_us
+                                      : wait_timeout_us;
+    z_mutex_unlock(z_loan_mut(wait_set_data->condition_mutex));
+    bool spin_resolved = rmw_zp_wait_set_spin(wait_set_data, &clock_start, spin_period_us);
     z_mutex_lock(z_loan_mut(wait_set_data->condition_mutex));
 
-    // According to the RMW documentation, if wait_timeout is NULL that means
-    // "wait forever", if it specified as 0 it means "never wait", and if it is
-    // anything else wait for that amount of time.
-    if (wait_timeout == NULL) {
-      while (!wait_set_data->triggered) {
-        z_condvar_wait(z_loan_mut(wait_set_data->condition_variable),
-                       z_loan_mut(wait_set_data->condition_mutex));
-      }
-    } else {
-      if (wait_timeout->sec != 0 || wait_timeout->nsec != 0) {
-        const size_t wait_timeout_us = rmw_time_to_us(wait_timeout);
-        const z_clock_t clock_start = z_clock_now();
+    if (spin_resolved) {
+      wait_set_data->spin_wakeup_count++;
+    }
+  }
+
+  bool wait_result = false;
 
-        while (!wait_set_data->triggered) {
+  for (;;) {
+    if (may_wait && wait_set_data->ready_list == NULL) {
+      if (wait_timeout == NULL) {
+        while (wait_set_data->ready_list == NULL) {
+          z_condvar_wait(z_loan_mut(wait_set_data->condition_variable),
+                         z_loan_mut(wait_set_data->condition_mutex));
+        }
+      } else {
+        while (wait_set_data->ready_list == NULL) {
           const size_t time_elapsed_us = z_clock_elapsed_us(&clock_start);
           if (time_elapsed_us >= wait_timeout_us) {
             break;
@@ -211,108 +303,90 @@ rmw_ret_t rmw_wait(rmw_subscriptions_t *subscriptions, rmw_guard_conditions_t *g
           }
         }
       }
+
+      if (wait_set_data->ready_list != NULL) {
+        wait_set_data->block_wakeup_count++;
+      }
     }
 
-    // It is important to reset this here while still holding the lock,
-    // otherwise every subsequent call to rmw_wait() will be immediately ready.
-    // We could handle this another way by making "triggered" a stack variable
-    // in this function and "attaching" it during "check_and_attach_condition",
-    // but that isn't clearly better so leaving this.
-    wait_set_data->triggered = false;
+    size_t ready_count = rmw_zp_wait_set_take_ready_list(wait_set_data);
     z_mutex_unlock(z_loan_mut(wait_set_data->condition_mutex));
-  }
 
-  bool wait_result = false;
+    // Entities with data left stay on the ready list. They are moved to the front of
+    // ready_attachments, which is only used by this function.
+    size_t stays_ready_count = 0;
+    for (size_t i = 0; i < ready_count; ++i) {
+      rmw_zp_wait_set_attachment_t *attachment = wait_set_data->ready_attachments[i];
+      void *entity = wait_set_data->entities[attachment - wait_set_data->attachments];
 
-  // According to the documentation for rmw_wait in rmw.h, entries in the
-  // various arrays that have *not* been triggered should be set to NULL
-  if (guard_conditions) {
-    for (size_t i = 0; i < guard_conditions->guard_condition_count; ++i) {
-      rmw_zp_guard_condition_t *gc = guard_conditions->guard_conditions[i];
-      if (gc == NULL) {
-        continue;
-      }
-      if (!rmw_zp_guard_condition_detach_condition_and_is_trigger_set(gc)) {
-        // Setting to NULL lets rcl know that this guard condition is not ready
-        guard_conditions->guard_conditions[i] = NULL;
-      } else {
+      bool stays_ready;
+      if (check_ready_attachment(attachment, entity, &stays_ready)) {
+        arrays[attachment->kind].entities[attachment->index] = entity;
         wait_result = true;
       }
+      if (stays_ready) {
+        wait_set_data->ready_attachments[stays_ready_count++] = attachment;
+      }
     }
-  }
 
-  if (events) {
-    for (size_t i = 0; i < events->event_count; ++i) {
-      rmw_event_t *event = events->events[i];
-      // TODO(bjsowa)
-      //       auto event_data =
-      //           static_cast<rmw_zenoh_cpp::EventsManager *>(event->data);
-      //       if (event_data == nullptr) {
-      //         continue;
-      //       }
-
-      //       rmw_zenoh_cpp::rmw_zenoh_event_type_t zenoh_event_type =
-      //           rmw_zenoh_cpp::zenoh_event_from_rmw_event(event->event_type);
-      //       if (zenoh_event_type == rmw_zenoh_cpp::ZENOH_EVENT_INVALID) {
-      //         continue;
-      //       }
-
-      //       if (event_data->detach_condition_and_event_queue_is_empty(
-      //               zenoh_event_type)) {
-      //         // Setting to nullptr lets rcl know that this subscription is not ready
-      //         events->events[i] = nullptr;
-      //       } else {
-      //         wait_result = true;
-      //       }
+    if (stays_ready_count > 0) {
+      rmw_zp_wait_set_restore_ready_list(wait_set_data, stays_ready_count);
     }
-  }
-
-  if (subscriptions) {
-    for (size_t i = 0; i < subscriptions->subscriber_count; ++i) {
-      rmw_zp_subscription_t *sub_data = subscriptions->subscribers[i];
-      if (sub_data == NULL) {
-        continue;
-      }
 
-      if (rmw_zp_subscription_detach_condition_and_queue_is_empty(sub_data)) {
-        // Setting to NULL lets rcl know that this subscription is not ready
-        subscriptions->subscribers[i] = NULL;
-      } else {
-        wait_result = true;
-      }
+    // The entities on the ready list may have nothing left by now, e.g. because another wait set
+    // took their data first or their messages expired. Keep waiting for the rest of the timeout.
+    if (wait_result || !may_wait ||
+        (wait_timeout != NULL && z_clock_elapsed_us(&clock_start) >= wait_timeout_us)) {
+      break;
     }
+
+    z_mutex_lock(z_loan_mut(wait_set_data->condition_mutex));
   }
 
-  if (services) {
-    for (size_t i = 0; i < services->service_count; ++i) {
-      rmw_zp_service_t *serv_data = services->services[i];
-      if (serv_data == NULL) {
-        continue;
-      }
+  return wait_result ? RMW_RET_OK : RMW_RET_TIMEOUT;
+}
 
-      if (rmw_zp_service_detach_condition_and_queue_is_empty(serv_data)) {
-        // Setting to nullptr lets rcl know that this service is not ready
-        services->services[i] = NULL;
-      } else {
-        wait_result = true;
-      }
-    }
-  }
+rmw_ret_t rmw_zenohpico_wait_set_set_spin_period(rmw_wait_set_t *wait_set, size_t spin_period_us) {
+  RMW_CHECK_ARGUMENT_FOR_NULL(wait_set, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(wait_set, wait_set->implementation_identifier, rmw_zp_identifier,
+                                   return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
 
-  if (clients) {
-    for (size_t i = 0; i < clients->client_count; ++i) {
-      rmw_zp_client_t *client_data = clients->clients[i];
-      if (client_data == NULL) {
-        continue;
-      }
+  rmw_zp_wait_set_t *wait_set_data = wait_set->data;
+  RMW_CHECK_ARGUMENT_FOR_NULL(wait_set_data, RMW_RET_INVALID_ARGUMENT);
 
-      if (rmw_zp_client_detach_condition_and_queue_is_empty(client_data)) {
-        clients->clients[i] = NULL;
-      } else {
-        wait_result = true;
-      }
-    }
-  }
+  z_mutex_lock(z_loan_mut(wait_set_data->condition_mutex));
+  wait_set_data->spin_period_us = spin_period_us;
+  z_mutex_unlock(z_loan_mut(wait_set_data->condition_mutex));
 
-  return wait_result ? RMW_RET_OK : RMW_RET_TIMEOUT;
+  return RMW_RET_OK;
+}
+
+rmw_ret_t rmw_zenohpico_wait_set_get_statistics(const rmw_wait_set_t *wait_set,
+                                                rmw_zenohpico_wait_set_statistics_t *statistics) {
+  RMW_CHECK_ARGUMENT_FOR_NULL(wait_set, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(wait_set, wait_set->implementation_identifier, rmw_zp_identifier,
+                                   return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+  RMW_CHECK_ARGUMENT_FOR_NULL(statistics, RMW_RET_INVALID_ARGUMENT);
+
+  rmw_zp_wait_set_t *wait_set_data = wait_set->data;
+  RMW_CHECK_ARGUMENT_FOR_NULL(wait_set_data, RMW_RET_INVALID_ARGUMENT);
+
+  z_mutex_lock(z_loan_mut(wait_set_data->condition_mutex));
+  statistics->spin_wakeup_count = wait_set_data->spin_wakeup_count;
+  statistics->block_wakeup_count = wait_set_data->block_wakeup_count;
+  z_mutex_unlock(z_loan_mut(wait_set_data->condition_mutex));
+
+  return RMW_RET_OK;
+}
+
+rmw_ret_t rmw_zenohpico_wait_set_get_fd(rmw_wait_set_t *wait_set, int *fd) {
+  RMW_CHECK_ARGUMENT_FOR_NULL(wait_set, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(wait_set, wait_set->implementation_identifier, rmw_zp_identifier,
+                                   return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+  RMW_CHECK_ARGUMENT_FOR_NULL(fd, RMW_RET_INVALID_ARGUMENT);
+
+  rmw_zp_wait_set_t *wait_set_data = wait_set->data;
+  RMW_CHECK_ARGUMENT_FOR_NULL(wait_set_data, RMW_RET_INVALID_ARGUMENT);
+
+  return rmw_zp_wait_set_get_event_fd(wait_set_data, fd);
 }
\ No newline at end of file
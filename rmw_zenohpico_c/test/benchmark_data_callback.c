@@ -0,0 +1,248 @@
+// Benchmark of waking up an executor for new messages, either through rmw_wait() as the wait-set
+// executors do, or through the data callback of the subscription as the events executor does. A
+// producer thread hands messages to a subscription at a fixed rate, as the zenoh data handler
+// would, and a consumer thread takes them. Prints the latency from publication to take and the CPU
+// time used per message.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "detail/attachment_helpers.h"
+#include "detail/identifiers.h"
+#include "detail/subscription.h"
+#include "detail/time.h"
+#include "detail/wait_set.h"
+#include "rcutils/allocator.h"
+#include "rmw/qos_profiles.h"
+#include "rmw/rmw.h"
+#include "zenoh-pico.h"
+
+#define MESSAGE_COUNT 2000
+#define PUBLISH_PERIOD_US 200
+
+typedef struct {
+  rcutils_allocator_t allocator;
+  rmw_zp_subscription_t subscription;
+
+  // Wait set given to rmw_wait(). The context only provides the allocator.
+  rmw_context_t context;
+  z_owned_mutex_t attachment_mutex;
+  rmw_zp_wait_set_t wait_set_data;
+  rmw_wait_set_t wait_set;
+
+  // Queue of the events executor: messages reported by the data callback and not taken yet.
+  z_owned_mutex_t event_mutex;
+  z_owned_condvar_t event_condition_variable;
+  size_t event_count;
+
+  // Only accessed by the consumer.
+  size_t received_count;
+  int64_t last_sequence_number;
+  bool is_ordered;
+  uint64_t latency_total_us;
+  uint64_t latency_max_us;
+} benchmark_t;
+
+static void *producer(void *arg) {
+  benchmark_t *benchmark = arg;
+
+  rmw_zp_attachment_data_t attachment_data;
+  memset(&attachment_data, 0, sizeof(attachment_data));
+
+  for (int64_t i = 0; i < MESSAGE_COUNT; i++) {
+    attachment_data.sequence_number = i;
+    if (rmw_zp_get_current_timestamp(&attachment_data.source_timestamp) != RMW_RET_OK) {
+      return NULL;
+    }
+
+    z_owned_bytes_t attachment;
+    if (rmw_zp_attachment_data_serialize_to_zbytes(&attachment_data,
+                                                   RMW_ZP_ATTACHMENT_FORMAT_COMPACT,
+                                                   &attachment) != RMW_RET_OK) {
+      return NULL;
+    }
+    z_owned_bytes_t payload;
+    z_bytes_empty(&payload);
+
+    rmw_zp_subscription_add_new_message(&benchmark->subscription, z_loan(attachment),
+                                        z_loan(payload));
+
+    z_drop(z_move(payload));
+    z_drop(z_move(attachment));
+
+    z_sleep_us(PUBLISH_PERIOD_US);
+  }
+
+  return NULL;
+}
+
+// Take up to `count` messages.
+static void take_messages(benchmark_t *benchmark, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    rmw_zp_message_t message;
+    if (!rmw_zp_subscription_pop_next_message(&benchmark->subscription, &message)) {
+      return;
+    }
+
+    int64_t now;
+    if (rmw_zp_get_current_timestamp(&now) == RMW_RET_OK) {
+      // Timestamps count fractions of a second in their lower 32 bits.
+      const uint64_t latency_us = ((uint64_t)(now - message.attachment_data.source_timestamp) *
+                                   1000000) >> 32;
+      benchmark->latency_total_us += latency_us;
+      if (latency_us > benchmark->latency_max_us) {
+        benchmark->latency_max_us = latency_us;
+      }
+    }
+
+    if (message.attachment_data.sequence_number != benchmark->last_sequence_number + 1) {
+      benchmark->is_ordered = false;
+    }
+    benchmark->last_sequence_number = message.attachment_data.sequence_number;
+    benchmark->received_count++;
+
+    rmw_zp_message_fini(&message);
+  }
+}
+
+static void *wait_set_consumer(void *arg) {
+  benchmark_t *benchmark = arg;
+  const rmw_time_t timeout = {1, 0};
+
+  while (benchmark->received_count < MESSAGE_COUNT) {
+    void *subscribers[] = {&benchmark->subscription};
+    rmw_subscriptions_t subscriptions = {.subscriber_count = 1, .subscribers = subscribers};
+    if (rmw_wait(&subscriptions, NULL, NULL, NULL, NULL, &benchmark->wait_set, &timeout) !=
+        RMW_RET_OK) {
+      return NULL;
+    }
+
+    take_messages(benchmark, SIZE_MAX);
+  }
+
+  return NULL;
+}
+
+static void on_new_message(const void *user_data, size_t count) {
+  benchmark_t *benchmark = (benchmark_t *)user_data;
+
+  z_mutex_lock(z_loan_mut(benchmark->event_mutex));
+  benchmark->event_count += count;
+  z_condvar_signal(z_loan_mut(benchmark->event_condition_variable));
+  z_mutex_unlock(z_loan_mut(benchmark->event_mutex));
+}
+
+static void *events_consumer(void *arg) {
+  benchmark_t *benchmark = arg;
+  const size_t timeout_us = 1000000;
+
+  while (benchmark->received_count < MESSAGE_COUNT) {
+    z_mutex_lock(z_loan_mut(benchmark->event_mutex));
+    z_clock_t clock_start = z_clock_now();
+    while (benchmark->event_count == 0 && z_clock_elapsed_us(&clock_start) < timeout_us) {
+      z_condvar_wait_for_us(z_loan_mut(benchmark->event_condition_variable),
+                            z_loan_mut(benchmark->event_mutex), timeout_us);
+    }
+    const size_t event_count = benchmark->event_count;
+    benchmark->event_count = 0;
+    z_mutex_unlock(z_loan_mut(benchmark->event_mutex));
+
+    if (event_count == 0) {
+      return NULL;
+    }
+
+    // The events executor takes one message per event.
+    take_messages(benchmark, event_count);
+  }
+
+  return NULL;
+}
+
+static bool benchmark_init(benchmark_t *benchmark) {
+  memset(benchmark, 0, sizeof(*benchmark));
+  benchmark->allocator = rcutils_get_default_allocator();
+  benchmark->last_sequence_number = -1;
+  benchmark->is_ordered = true;
+
+  // Deep enough for no message to be lost if the consumer falls behind.
+  rmw_qos_profile_t qos_profile = rmw_qos_profile_default;
+  qos_profile.depth = MESSAGE_COUNT;
+
+  // The deadline is infinite, so no timer wheel is needed.
+  if (rmw_zp_subscription_init(&benchmark->subscription, &qos_profile, &benchmark->allocator,
+                               NULL) != RMW_RET_OK) {
+    return false;
+  }
+
+  benchmark->context = rmw_get_zero_initialized_context();
+  benchmark->context.options.allocator = benchmark->allocator;
+  z_mutex_init(&benchmark->attachment_mutex);
+  if (rmw_zp_wait_set_init(&benchmark->wait_set_data, &benchmark->attachment_mutex) !=
+      RMW_RET_OK) {
+    return false;
+  }
+  benchmark->wait_set_data.context = &benchmark->context;
+  benchmark->wait_set.implementation_identifier = rmw_zp_identifier;
+  benchmark->wait_set.data = &benchmark->wait_set_data;
+
+  z_mutex_init(&benchmark->event_mutex);
+  z_condvar_init(&benchmark->event_condition_variable);
+
+  return true;
+}
+
+static void benchmark_fini(benchmark_t *benchmark) {
+  // The subscription detaches itself from the wait set.
+  rmw_zp_subscription_fini(&benchmark->subscription, &benchmark->allocator);
+  rmw_zp_wait_set_fini(&benchmark->wait_set_data);
+  z_drop(z_move(benchmark->attachment_mutex));
+  z_drop(z_move(benchmark->event_condition_variable));
+  z_drop(z_move(benchmark->event_mutex));
+}
+
+static bool run(const char *name, bool use_events) {
+  benchmark_t benchmark;
+  if (!benchmark_init(&benchmark)) {
+    fprintf(stderr, "%s: failed to initialize\n", name);
+    return false;
+  }
+
+  if (use_events) {
+    rmw_zp_subscription_set_data_callback(&benchmark.subscription, on_new_message, &benchmark);
+  }
+
+  const clock_t cpu_start = clock();
+
+  z_owned_task_t consumer_task;
+  z_owned_task_t producer_task;
+  z_task_init(&consumer_task, NULL, use_events ? events_consumer : wait_set_consumer, &benchmark);
+  z_task_init(&producer_task, NULL, producer, &benchmark);
+  z_task_join(z_move(producer_task));
+  z_task_join(z_move(consumer_task));
+
+  const double cpu_us = (double)(clock() - cpu_start) * 1e6 / CLOCKS_PER_SEC;
+
+  bool ok = true;
+  if (benchmark.received_count != MESSAGE_COUNT || !benchmark.is_ordered) {
+    fprintf(stderr, "%s: %zu messages received out of %d, %s\n", name, benchmark.received_count,
+            MESSAGE_COUNT, benchmark.is_ordered ? "in order" : "out of order");
+    ok = false;
+  } else {
+    printf("%-9s latency %6.1f us (max %5lu us), CPU %6.1f us per message\n", name,
+           (double)benchmark.latency_total_us / MESSAGE_COUNT,
+           (unsigned long)benchmark.latency_max_us, cpu_us / MESSAGE_COUNT);
+  }
+
+  benchmark_fini(&benchmark);
+  return ok;
+}
+
+int main(void) {
+  bool ok = run("wait set", false);
+  ok = run("events", true) && ok;
+
+  return ok ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,145 @@
+// Benchmark of replaying serialized messages, as bag players and bridges do. Every message is
+// either deserialized and published with rmw_publish(), which serializes it again, or handed as is
+// to rmw_publish_serialized_message(). Needs a zenoh router on the default locator, so it is only
+// built and not run as a test.
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "rcutils/allocator.h"
+#include "rmw/error_handling.h"
+#include "rmw/rmw.h"
+#include "rmw/serialized_message.h"
+#include "rosidl_runtime_c/string_functions.h"
+#include "std_msgs/msg/string.h"
+#include "zenoh-pico.h"
+
+#define MESSAGE_COUNT 20000
+
+typedef struct {
+  rmw_publisher_t *publisher;
+  const rosidl_message_type_support_t *type_support;
+  rmw_serialized_message_t serialized_message;
+  // Message the serialized message is deserialized into on every publication, as a replay that
+  // goes through the ROS message would.
+  std_msgs__msg__String message;
+} benchmark_t;
+
+static bool publish_deserialized(benchmark_t *benchmark) {
+  return rmw_deserialize(&benchmark->serialized_message, benchmark->type_support,
+                         &benchmark->message) == RMW_RET_OK &&
+         rmw_publish(benchmark->publisher, &benchmark->message, NULL) == RMW_RET_OK;
+}
+
+static bool publish_serialized(benchmark_t *benchmark) {
+  return rmw_publish_serialized_message(benchmark->publisher, &benchmark->serialized_message,
+                                        NULL) == RMW_RET_OK;
+}
+
+static bool run(benchmark_t *benchmark, const char *name, bool (*publish)(benchmark_t *)) {
+  z_clock_t clock_start = z_clock_now();
+  for (size_t i = 0; i < MESSAGE_COUNT; i++) {
+    if (!publish(benchmark)) {
+      fprintf(stderr, "%s: failed to publish: %s\n", name, rmw_get_error_string().str);
+      rmw_reset_error();
+      return false;
+    }
+  }
+  const double elapsed_s = (double)z_clock_elapsed_us(&clock_start) / 1e6;
+
+  const size_t size = benchmark->serialized_message.buffer_length;
+  printf("%-14s %8zu bytes: %10.0f msg/s %10.1f MB/s\n", name, size, MESSAGE_COUNT / elapsed_s,
+         (double)(MESSAGE_COUNT * size) / elapsed_s / 1e6);
+  return true;
+}
+
+static bool run_size(rmw_publisher_t *publisher, size_t size, rcutils_allocator_t *allocator) {
+  benchmark_t benchmark;
+  benchmark.publisher = publisher;
+  benchmark.type_support = ROSIDL_GET_MSG_TYPE_SUPPORT(std_msgs, msg, String);
+  benchmark.serialized_message = rmw_get_zero_initialized_serialized_message();
+
+  bool ok = false;
+  if (!std_msgs__msg__String__init(&benchmark.message)) {
+    fprintf(stderr, "%zu bytes: failed to initialize the message\n", size);
+    return false;
+  }
+
+  char *data = allocator->allocate(size, allocator->state);
+  if (data == NULL) {
+    fprintf(stderr, "%zu bytes: failed to allocate the message data\n", size);
+    goto fail_allocate_data;
+  }
+  memset(data, 'x', size);
+
+  if (!rosidl_runtime_c__String__assignn(&benchmark.message.data, data, size) ||
+      rmw_serialized_message_init(&benchmark.serialized_message, 0, allocator) != RMW_RET_OK ||
+      rmw_serialize(&benchmark.message, benchmark.type_support, &benchmark.serialized_message) !=
+          RMW_RET_OK) {
+    fprintf(stderr, "%zu bytes: failed to serialize the message: %s\n", size,
+            rmw_get_error_string().str);
+    rmw_reset_error();
+    goto fail_serialize;
+  }
+
+  ok = run(&benchmark, "deserialized", publish_deserialized) &&
+       run(&benchmark, "serialized", publish_serialized);
+
+fail_serialize:
+  ok = rmw_serialized_message_fini(&benchmark.serialized_message) == RMW_RET_OK && ok;
+  allocator->deallocate(data, allocator->state);
+fail_allocate_data:
+  std_msgs__msg__String__fini(&benchmark.message);
+  return ok;
+}
+
+int main(void) {
+  const size_t sizes[] = {64, 1024, 16384};
+
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  rmw_init_options_t init_options = rmw_get_zero_initialized_init_options();
+  rmw_context_t context = rmw_get_zero_initialized_context();
+  rmw_publisher_options_t publisher_options = rmw_get_default_publisher_options();
+  rmw_node_t *node = NULL;
+  rmw_publisher_t *publisher = NULL;
+
+  bool ok = false;
+  if (rmw_init_options_init(&init_options, allocator) != RMW_RET_OK) {
+    goto fail_init_options;
+  }
+  if (rmw_init(&init_options, &context) != RMW_RET_OK) {
+    goto fail_init;
+  }
+
+  node = rmw_create_node(&context, "benchmark_publish_serialized", "/");
+  if (node == NULL) {
+    goto fail_create_node;
+  }
+
+  publisher = rmw_create_publisher(node, ROSIDL_GET_MSG_TYPE_SUPPORT(std_msgs, msg, String),
+                                   "benchmark_publish_serialized", &rmw_qos_profile_default,
+                                   &publisher_options);
+  if (publisher == NULL) {
+    goto fail_create_publisher;
+  }
+
+  ok = true;
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]) && ok; i++) {
+    ok = run_size(publisher, sizes[i], &allocator);
+  }
+
+  ok = rmw_destroy_publisher(node, publisher) == RMW_RET_OK && ok;
+fail_create_publisher:
+  ok = rmw_destroy_node(node) == RMW_RET_OK && ok;
+fail_create_node:
+  ok = rmw_shutdown(&context) == RMW_RET_OK && ok;
+  ok = rmw_context_fini(&context) == RMW_RET_OK && ok;
+fail_init:
+  ok = rmw_init_options_fini(&init_options) == RMW_RET_OK && ok;
+fail_init_options:
+  if (rmw_error_is_set()) {
+    fprintf(stderr, "%s\n", rmw_get_error_string().str);
+  }
+  return ok ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,239 @@
+// Benchmark of the round-trip time of service calls for each query target and consolidation of the
+// client. A service and a client of the same process exchange std_srvs/Empty requests through a
+// zenoh router on the default locator, so it is only built and not run as a test.
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "rcutils/allocator.h"
+#include "rmw/error_handling.h"
+#include "rmw/rmw.h"
+#include "rmw_zenohpico_c/client.h"
+#include "std_srvs/srv/empty.h"
+#include "zenoh-pico.h"
+
+#define REQUEST_COUNT 1000
+// Requests sent until the service answers one, before measuring.
+#define WARM_UP_REQUEST_COUNT 10
+#define TIMEOUT_MS 1000
+
+typedef struct {
+  const char *name;
+  rmw_zenohpico_query_target_t target;
+  rmw_zenohpico_query_consolidation_t consolidation;
+} query_mode_t;
+
+typedef struct {
+  rmw_service_t *service;
+  rmw_wait_set_t *wait_set;
+  atomic_bool is_done;
+  bool ok;
+} server_t;
+
+static void *serve(void *arg) {
+  server_t *server = arg;
+  const rmw_time_t timeout = {0, 100000000};
+
+  std_srvs__srv__Empty_Request request;
+  std_srvs__srv__Empty_Response response;
+  std_srvs__srv__Empty_Request__init(&request);
+  std_srvs__srv__Empty_Response__init(&response);
+
+  while (!atomic_load(&server->is_done)) {
+    void *services[] = {server->service->data};
+    rmw_services_t service_array = {.service_count = 1, .services = services};
+    rmw_ret_t ret = rmw_wait(NULL, NULL, &service_array, NULL, NULL, server->wait_set, &timeout);
+    if (ret == RMW_RET_TIMEOUT) {
+      continue;
+    }
+
+    rmw_service_info_t request_header;
+    bool taken = false;
+    if (ret != RMW_RET_OK ||
+        rmw_take_request(server->service, &request_header, &request, &taken) != RMW_RET_OK ||
+        (taken && rmw_send_response(server->service, &request_header.request_id, &response) !=
+                      RMW_RET_OK)) {
+      server->ok = false;
+      break;
+    }
+  }
+
+  std_srvs__srv__Empty_Response__fini(&response);
+  std_srvs__srv__Empty_Request__fini(&request);
+  return NULL;
+}
+
+// Send a request and wait for its response. Returns false if there was none within TIMEOUT_MS.
+static bool call(rmw_client_t *client, rmw_wait_set_t *wait_set) {
+  const rmw_time_t timeout = {TIMEOUT_MS / 1000, (TIMEOUT_MS % 1000) * 1000000};
+
+  std_srvs__srv__Empty_Request request;
+  std_srvs__srv__Empty_Response response;
+  std_srvs__srv__Empty_Request__init(&request);
+  std_srvs__srv__Empty_Response__init(&response);
+
+  bool taken = false;
+  int64_t sequence_number;
+  if (rmw_send_request(client, &request, &sequence_number) == RMW_RET_OK) {
+    z_clock_t clock_start = z_clock_now();
+    while (!taken && z_clock_elapsed_ms(&clock_start) < TIMEOUT_MS) {
+      void *clients[] = {client->data};
+      rmw_clients_t client_array = {.client_count = 1, .clients = clients};
+      rmw_ret_t ret = rmw_wait(NULL, NULL, NULL, &client_array, NULL, wait_set, &timeout);
+      if (ret == RMW_RET_TIMEOUT) {
+        continue;
+      }
+
+      rmw_service_info_t request_header;
+      if (ret != RMW_RET_OK ||
+          rmw_take_response(client, &request_header, &response, &taken) != RMW_RET_OK) {
+        break;
+      }
+      // A late response to an earlier request does not count.
+      taken = taken && request_header.request_id.sequence_number == sequence_number;
+    }
+  }
+
+  std_srvs__srv__Empty_Response__fini(&response);
+  std_srvs__srv__Empty_Request__fini(&request);
+  return taken;
+}
+
+static bool run(rmw_client_t *client, rmw_wait_set_t *wait_set, const query_mode_t *mode) {
+  if (rmw_zenohpico_client_set_query_target(client, mode->target) != RMW_RET_OK ||
+      rmw_zenohpico_client_set_query_consolidation(client, mode->consolidation) != RMW_RET_OK) {
+    fprintf(stderr, "%s: failed to configure the client\n", mode->name);
+    return false;
+  }
+
+  bool is_answered = false;
+  for (size_t i = 0; i < WARM_UP_REQUEST_COUNT && !is_answered; i++) {
+    is_answered = call(client, wait_set);
+  }
+  if (!is_answered) {
+    fprintf(stderr, "%s: the service did not answer\n", mode->name);
+    return false;
+  }
+
+  uint64_t total_us = 0;
+  uint64_t min_us = UINT64_MAX;
+  uint64_t max_us = 0;
+  for (size_t i = 0; i < REQUEST_COUNT; i++) {
+    z_clock_t clock_start = z_clock_now();
+    if (!call(client, wait_set)) {
+      fprintf(stderr, "%s: request %zu got no response\n", mode->name, i);
+      return false;
+    }
+    const uint64_t round_trip_us = z_clock_elapsed_us(&clock_start);
+
+    total_us += round_trip_us;
+    min_us = round_trip_us < min_us ? round_trip_us : min_us;
+    max_us = round_trip_us > max_us ? round_trip_us : max_us;
+  }
+
+  printf("%-22s round trip %8.1f us (min %6lu us, max %6lu us)\n", mode->name,
+         (double)total_us / REQUEST_COUNT, (unsigned long)min_us, (unsigned long)max_us);
+  return true;
+}
+
+// Run every mode while a thread serves the requests.
+static bool run_all(rmw_service_t *service, rmw_wait_set_t *server_wait_set, rmw_client_t *client,
+                    rmw_wait_set_t *client_wait_set) {
+  const query_mode_t modes[] = {
+      {"all_complete/latest", RMW_ZENOHPICO_QUERY_TARGET_ALL_COMPLETE,
+       RMW_ZENOHPICO_QUERY_CONSOLIDATION_LATEST},
+      {"all_complete/none", RMW_ZENOHPICO_QUERY_TARGET_ALL_COMPLETE,
+       RMW_ZENOHPICO_QUERY_CONSOLIDATION_NONE},
+      {"best_matching/latest", RMW_ZENOHPICO_QUERY_TARGET_BEST_MATCHING,
+       RMW_ZENOHPICO_QUERY_CONSOLIDATION_LATEST},
+      {"best_matching/none", RMW_ZENOHPICO_QUERY_TARGET_BEST_MATCHING,
+       RMW_ZENOHPICO_QUERY_CONSOLIDATION_NONE},
+  };
+
+  // Requests sent before the service is reachable are given up on.
+  if (rmw_zenohpico_client_set_query_timeout(client, TIMEOUT_MS) != RMW_RET_OK) {
+    return false;
+  }
+
+  server_t server = {.service = service, .wait_set = server_wait_set, .ok = true};
+  atomic_init(&server.is_done, false);
+  z_owned_task_t server_task;
+  z_task_init(&server_task, NULL, serve, &server);
+
+  bool ok = true;
+  for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]) && ok; i++) {
+    ok = run(client, client_wait_set, &modes[i]);
+  }
+
+  atomic_store(&server.is_done, true);
+  z_task_join(z_move(server_task));
+  return server.ok && ok;
+}
+
+int main(void) {
+  const rosidl_service_type_support_t *type_support =
+      ROSIDL_GET_SRV_TYPE_SUPPORT(std_srvs, srv, Empty);
+
+  rmw_init_options_t init_options = rmw_get_zero_initialized_init_options();
+  rmw_context_t context = rmw_get_zero_initialized_context();
+  rmw_node_t *node = NULL;
+  rmw_service_t *service = NULL;
+  rmw_client_t *client = NULL;
+  rmw_wait_set_t *server_wait_set = NULL;
+  rmw_wait_set_t *client_wait_set = NULL;
+
+  bool ok = false;
+  if (rmw_init_options_init(&init_options, rcutils_get_default_allocator()) != RMW_RET_OK) {
+    goto fail_init_options;
+  }
+  if (rmw_init(&init_options, &context) != RMW_RET_OK) {
+    goto fail_init;
+  }
+
+  node = rmw_create_node(&context, "benchmark_service_round_trip", "/");
+  if (node == NULL) {
+    goto fail_create_node;
+  }
+  service = rmw_create_service(node, type_support, "benchmark_service_round_trip",
+                               &rmw_qos_profile_services_default);
+  if (service == NULL) {
+    goto fail_create_service;
+  }
+  client = rmw_create_client(node, type_support, "benchmark_service_round_trip",
+                             &rmw_qos_profile_services_default);
+  if (client == NULL) {
+    goto fail_create_client;
+  }
+  server_wait_set = rmw_create_wait_set(&context, 1);
+  if (server_wait_set == NULL) {
+    goto fail_create_server_wait_set;
+  }
+  client_wait_set = rmw_create_wait_set(&context, 1);
+  if (client_wait_set == NULL) {
+    goto fail_create_client_wait_set;
+  }
+
+  ok = run_all(service, server_wait_set, client, client_wait_set);
+
+  ok = rmw_destroy_wait_set(client_wait_set) == RMW_RET_OK && ok;
+fail_create_client_wait_set:
+  ok = rmw_destroy_wait_set(server_wait_set) == RMW_RET_OK && ok;
+fail_create_server_wait_set:
+  ok = rmw_destroy_client(node, client) == RMW_RET_OK && ok;
+fail_create_client:
+  ok = rmw_destroy_service(node, service) == RMW_RET_OK && ok;
+fail_create_service:
+  ok = rmw_destroy_node(node) == RMW_RET_OK && ok;
+fail_create_node:
+  ok = rmw_shutdown(&context) == RMW_RET_OK && ok;
+  ok = rmw_context_fini(&context) == RMW_RET_OK && ok;
+fail_init:
+  ok = rmw_init_options_fini(&init_options) == RMW_RET_OK && ok;
+fail_init_options:
+  if (rmw_error_is_set()) {
+    fprintf(stderr, "%s\n", rmw_get_error_string().str);
+  }
+  return ok ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,159 @@
+// Benchmark of rmw_wait() on a wait set of 10, 100 and 1000 guard conditions, polling when none of
+// them is ready and waiting for one that is triggered. Each call is given the same entities, as
+// executors do as long as they do not add or remove any. rmw_wait() then only compares them with
+// the previous ones and looks at the ready ones, so its cost should barely grow with their number.
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "detail/guard_condition.h"
+#include "detail/identifiers.h"
+#include "detail/wait_set.h"
+#include "rcutils/allocator.h"
+#include "rmw/rmw.h"
+#include "zenoh-pico.h"
+
+#define ITERATION_COUNT 10000
+
+typedef struct {
+  rcutils_allocator_t allocator;
+  size_t count;
+  rmw_zp_guard_condition_t *guard_conditions;
+  // The guard conditions, and the array given to rmw_wait() that it sets the ones that are not
+  // ready to NULL in.
+  void **entities;
+  void **ready_entities;
+
+  // Wait set given to rmw_wait(). The context only provides the allocator.
+  rmw_context_t context;
+  z_owned_mutex_t attachment_mutex;
+  rmw_zp_wait_set_t wait_set_data;
+  rmw_wait_set_t wait_set;
+} benchmark_t;
+
+static bool benchmark_init(benchmark_t *benchmark, size_t count) {
+  memset(benchmark, 0, sizeof(*benchmark));
+  benchmark->allocator = rcutils_get_default_allocator();
+  rcutils_allocator_t *allocator = &benchmark->allocator;
+
+  benchmark->count = count;
+  benchmark->guard_conditions =
+      allocator->zero_allocate(count, sizeof(rmw_zp_guard_condition_t), allocator->state);
+  benchmark->entities = allocator->allocate(count * sizeof(void *), allocator->state);
+  benchmark->ready_entities = allocator->allocate(count * sizeof(void *), allocator->state);
+  if (benchmark->guard_conditions == NULL || benchmark->entities == NULL ||
+      benchmark->ready_entities == NULL) {
+    return false;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    if (rmw_zp_guard_condition_init(&benchmark->guard_conditions[i]) != RMW_RET_OK) {
+      return false;
+    }
+    benchmark->entities[i] = &benchmark->guard_conditions[i];
+  }
+
+  benchmark->context = rmw_get_zero_initialized_context();
+  benchmark->context.options.allocator = benchmark->allocator;
+  z_mutex_init(&benchmark->attachment_mutex);
+  if (rmw_zp_wait_set_init(&benchmark->wait_set_data, &benchmark->attachment_mutex) !=
+      RMW_RET_OK) {
+    return false;
+  }
+  benchmark->wait_set_data.context = &benchmark->context;
+  benchmark->wait_set.implementation_identifier = rmw_zp_identifier;
+  benchmark->wait_set.data = &benchmark->wait_set_data;
+
+  return true;
+}
+
+static void benchmark_fini(benchmark_t *benchmark) {
+  rcutils_allocator_t *allocator = &benchmark->allocator;
+
+  rmw_zp_wait_set_fini(&benchmark->wait_set_data);
+  z_drop(z_move(benchmark->attachment_mutex));
+  for (size_t i = 0; i < benchmark->count; i++) {
+    rmw_zp_guard_condition_fini(&benchmark->guard_conditions[i]);
+  }
+
+  allocator->deallocate(benchmark->ready_entities, allocator->state);
+  allocator->deallocate(benchmark->entities, allocator->state);
+  allocator->deallocate(benchmark->guard_conditions, allocator->state);
+}
+
+static rmw_ret_t wait_for_guard_conditions(benchmark_t *benchmark, const rmw_time_t *timeout) {
+  memcpy(benchmark->ready_entities, benchmark->entities, benchmark->count * sizeof(void *));
+  rmw_guard_conditions_t guard_conditions = {.guard_condition_count = benchmark->count,
+                                             .guard_conditions = benchmark->ready_entities};
+  return rmw_wait(NULL, &guard_conditions, NULL, NULL, NULL, &benchmark->wait_set, timeout);
+}
+
+// Trigger every guard condition in turn, and check that rmw_wait() reports only that one.
+static bool check(benchmark_t *benchmark) {
+  const rmw_time_t timeout = {1, 0};
+
+  for (size_t i = 0; i < benchmark->count; i++) {
+    rmw_zp_guard_condition_trigger(&benchmark->guard_conditions[i]);
+    if (wait_for_guard_conditions(benchmark, &timeout) != RMW_RET_OK) {
+      fprintf(stderr, "%zu entities: guard condition %zu was not reported\n", benchmark->count, i);
+      return false;
+    }
+
+    for (size_t j = 0; j < benchmark->count; j++) {
+      if ((benchmark->ready_entities[j] != NULL) != (j == i)) {
+        fprintf(stderr, "%zu entities: guard condition %zu was reported instead of %zu\n",
+                benchmark->count, j, i);
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+static bool run(size_t count) {
+  benchmark_t benchmark;
+  if (!benchmark_init(&benchmark, count)) {
+    fprintf(stderr, "%zu entities: failed to initialize\n", count);
+    return false;
+  }
+
+  bool ok = check(&benchmark);
+
+  const rmw_time_t zero_timeout = {0, 0};
+  z_clock_t clock_start = z_clock_now();
+  for (size_t i = 0; i < ITERATION_COUNT && ok; i++) {
+    ok = wait_for_guard_conditions(&benchmark, &zero_timeout) == RMW_RET_TIMEOUT;
+  }
+  const unsigned long poll_us = z_clock_elapsed_us(&clock_start);
+
+  const rmw_time_t timeout = {1, 0};
+  clock_start = z_clock_now();
+  for (size_t i = 0; i < ITERATION_COUNT && ok; i++) {
+    rmw_zp_guard_condition_trigger(&benchmark.guard_conditions[i % count]);
+    ok = wait_for_guard_conditions(&benchmark, &timeout) == RMW_RET_OK;
+  }
+  const unsigned long ready_us = z_clock_elapsed_us(&clock_start);
+
+  if (ok) {
+    printf("%4zu entities: %7.1f ns per poll, %7.1f ns per wait for a ready one\n", count,
+           poll_us * 1000.0 / ITERATION_COUNT, ready_us * 1000.0 / ITERATION_COUNT);
+  } else {
+    fprintf(stderr, "%zu entities: rmw_wait() failed\n", count);
+  }
+
+  benchmark_fini(&benchmark);
+  return ok;
+}
+
+int main(void) {
+  const size_t counts[] = {10, 100, 1000};
+
+  bool ok = true;
+  for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+    ok = run(counts[i]) && ok;
+  }
+
+  return ok ? 0 : 1;
+}
\ No newline at end of file
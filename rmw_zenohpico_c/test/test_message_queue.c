@@ -0,0 +1,178 @@
+// Stress test of rmw_zp_message_queue_t. One producer pushes numbered messages into a small queue,
+// dropping the oldest ones when it is full, while several consumers pop them concurrently. Every
+// message must come out exactly once, and each consumer must get them in order.
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "detail/message_queue.h"
+#include "rcutils/allocator.h"
+#include "zenoh-pico.h"
+
+#define MESSAGE_COUNT 100000
+#define CONSUMER_COUNT 3
+
+typedef struct {
+  rmw_zp_message_queue_t queue;
+  rcutils_allocator_t allocator;
+  atomic_bool is_done;
+  // Number of expired messages dropped by the consumers, which do not say which ones.
+  atomic_size_t expired_count;
+} test_context_t;
+
+typedef struct {
+  test_context_t *context;
+  size_t index;
+  // How many times each message came out of the queue through this thread.
+  uint8_t *counts;
+  bool is_ordered;
+} test_thread_t;
+
+static void message_init(rmw_zp_message_t *message, int64_t number) {
+  memset(message, 0, sizeof(*message));
+  message->attachment_data.sequence_number = number;
+  message->attachment_data.source_timestamp = number;
+  z_bytes_empty(&message->payload);
+}
+
+static void count_message(test_thread_t *thread, rmw_zp_message_t *message, int64_t *last_number) {
+  const int64_t number = message->attachment_data.sequence_number;
+  if (number < 0 || number >= MESSAGE_COUNT) {
+    thread->is_ordered = false;
+    return;
+  }
+  if (number <= *last_number) {
+    thread->is_ordered = false;
+  }
+  *last_number = number;
+  thread->counts[number]++;
+  rmw_zp_message_fini(message);
+}
+
+static void *producer(void *arg) {
+  test_thread_t *thread = arg;
+  int64_t last_dropped = -1;
+
+  for (int64_t i = 0; i < MESSAGE_COUNT; i++) {
+    rmw_zp_message_t message;
+    rmw_zp_message_t dropped_message;
+    message_init(&message, i);
+    if (rmw_zp_message_queue_push_back(&thread->context->queue, &message, &dropped_message)) {
+      count_message(thread, &dropped_message, &last_dropped);
+    }
+  }
+
+  atomic_store(&thread->context->is_done, true);
+  return NULL;
+}
+
+static void *consumer(void *arg) {
+  test_thread_t *thread = arg;
+  test_context_t *context = thread->context;
+  int64_t last_number = -1;
+
+  for (size_t round = 0;; round++) {
+    const bool is_done = atomic_load(&context->is_done);
+
+    rmw_zp_message_t messages[2];
+    size_t n;
+    switch ((round + thread->index) % 3) {
+      case 0:
+        n = rmw_zp_message_queue_pop_front(&context->queue, &messages[0]) ? 1 : 0;
+        break;
+      case 1:
+        n = rmw_zp_message_queue_pop_front_n(&context->queue, messages, 2);
+        break;
+      default:
+        // Expire the messages that are a bit older than the last one this thread got.
+        atomic_fetch_add(&context->expired_count,
+                         rmw_zp_message_queue_drop_expired(&context->queue, last_number - 8));
+        n = 0;
+        break;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+      count_message(thread, &messages[i], &last_number);
+    }
+
+    if (is_done && rmw_zp_message_queue_is_empty(&context->queue)) {
+      return NULL;
+    }
+  }
+}
+
+static bool run(size_t capacity) {
+  test_context_t context;
+  context.allocator = rcutils_get_default_allocator();
+  atomic_init(&context.is_done, false);
+  atomic_init(&context.expired_count, 0);
+  if (rmw_zp_message_queue_init(&context.queue, capacity, &context.allocator) != RMW_RET_OK) {
+    fprintf(stderr, "capacity %zu: failed to initialize the queue\n", capacity);
+    return false;
+  }
+
+  test_thread_t threads[CONSUMER_COUNT + 1];
+  z_owned_task_t tasks[CONSUMER_COUNT + 1];
+  for (size_t i = 0; i <= CONSUMER_COUNT; i++) {
+    threads[i].context = &context;
+    threads[i].index = i;
+    threads[i].counts = context.allocator.zero_allocate(MESSAGE_COUNT, 1, context.allocator.state);
+    threads[i].is_ordered = true;
+  }
+
+  // The consumers are started first, so that they race with the producer from the start.
+  for (size_t i = 1; i <= CONSUMER_COUNT; i++) {
+    z_task_init(&tasks[i], NULL, consumer, &threads[i]);
+  }
+  z_task_init(&tasks[0], NULL, producer, &threads[0]);
+  for (size_t i = 0; i <= CONSUMER_COUNT; i++) {
+    z_task_join(z_move(tasks[i]));
+  }
+
+  bool ok = true;
+  size_t received_count = 0;
+  for (size_t i = 0; i <= CONSUMER_COUNT; i++) {
+    if (!threads[i].is_ordered) {
+      fprintf(stderr, "capacity %zu: thread %zu got messages out of order\n", capacity, i);
+      ok = false;
+    }
+  }
+  for (size_t number = 0; number < MESSAGE_COUNT; number++) {
+    size_t count = 0;
+    for (size_t i = 0; i <= CONSUMER_COUNT; i++) {
+      count += threads[i].counts[number];
+    }
+    if (count > 1) {
+      fprintf(stderr, "capacity %zu: message %zu came out %zu times\n", capacity, number, count);
+      ok = false;
+    }
+    received_count += count;
+  }
+  if (received_count + atomic_load(&context.expired_count) != MESSAGE_COUNT) {
+    fprintf(stderr, "capacity %zu: %zu messages received and %zu expired out of %d\n", capacity,
+            received_count, atomic_load(&context.expired_count), MESSAGE_COUNT);
+    ok = false;
+  }
+
+  for (size_t i = 0; i <= CONSUMER_COUNT; i++) {
+    context.allocator.deallocate(threads[i].counts, context.allocator.state);
+  }
+  rmw_zp_message_queue_fini(&context.queue, &context.allocator);
+
+  return ok;
+}
+
+int main(void) {
+  // A capacity of 3 leaves a spare slot, since the number of slots is rounded up to 4.
+  const size_t capacities[] = {1, 3, 4, 16};
+
+  bool ok = true;
+  for (size_t i = 0; i < sizeof(capacities) / sizeof(capacities[0]); i++) {
+    ok = run(capacities[i]) && ok;
+  }
+
+  return ok ? 0 : 1;
+}
\ No newline at end of file